@@ -0,0 +1,187 @@
+#include "s21_inverse_tracker.h"
+
+#include <algorithm>
+
+S21InverseTracker::S21InverseTracker(const S21Matrix &matrix,
+                                     double drift_threshold)
+    : matrix_(matrix),
+      inverse_(matrix.GetRows(), matrix.GetCols()),
+      determinant_{},
+      drift_{},
+      drift_threshold_{},
+      refactor_count_{} {
+  matrix_.CheckIfMatrixIsSquare();
+  matrix_.Detach();
+  SetDriftThreshold(drift_threshold);
+  Refactor();
+  refactor_count_ = 0;
+}
+
+const S21Matrix &S21InverseTracker::GetMatrix() const noexcept {
+  return matrix_;
+}
+
+const S21Matrix &S21InverseTracker::GetInverse() const noexcept {
+  return inverse_;
+}
+
+double S21InverseTracker::GetDeterminant() const noexcept {
+  return determinant_;
+}
+
+double S21InverseTracker::GetDrift() const noexcept { return drift_; }
+
+double S21InverseTracker::GetDriftThreshold() const noexcept {
+  return drift_threshold_;
+}
+
+void S21InverseTracker::SetDriftThreshold(double drift_threshold) {
+  if (!(drift_threshold > 0)) {
+    throw std::invalid_argument("The drift threshold must be positive");
+  }
+  drift_threshold_ = drift_threshold;
+}
+
+int S21InverseTracker::GetRefactorCount() const noexcept {
+  return refactor_count_;
+}
+
+void S21InverseTracker::Refactor() { Factor(matrix_); }
+
+void S21InverseTracker::Factor(const S21Matrix &matrix) {
+  S21Matrix factors(matrix);
+  factors.Detach();
+  std::vector<int> pivots;
+  const int sign = factors.LuDecompose(pivots);
+  if (!sign) {
+    throw std::logic_error("The determinant of a matrix cannot be 0");
+  }
+  double determinant = sign;
+  for (int i = 0; i < factors.rows_; i++) {
+    determinant *= factors.matrix_[i][i];
+  }
+  S21Matrix inverse(matrix.rows_, matrix.cols_);
+  inverse.FillIdentity();
+  factors.LuSolve(pivots, inverse);
+  if (&matrix != &matrix_) {
+    matrix_ = matrix;
+    matrix_.Detach();
+  }
+  inverse_ = std::move(inverse);
+  determinant_ = determinant;
+  refactor_count_++;
+  ProbeDrift();
+}
+
+void S21InverseTracker::UpdateRow(int row, const S21Matrix &values) {
+  const int size = matrix_.rows_;
+  if (row < 0 || row >= size) {
+    throw std::out_of_range("Matrix index(es) are out of bounds");
+  }
+  if (values.rows_ != 1 || values.cols_ != size) {
+    throw std::invalid_argument("The row must be a 1 x n matrix");
+  }
+  S21Matrix u(size, 1), v(size, 1);
+  u.matrix_[row][0] = 1;
+  for (int j = 0; j < size; j++) {
+    v.matrix_[j][0] = values.matrix_[0][j] - matrix_.matrix_[row][j];
+  }
+  RankUpdate(u, v);
+}
+
+void S21InverseTracker::UpdateCol(int col, const S21Matrix &values) {
+  const int size = matrix_.rows_;
+  if (col < 0 || col >= size) {
+    throw std::out_of_range("Matrix index(es) are out of bounds");
+  }
+  if (values.rows_ != size || values.cols_ != 1) {
+    throw std::invalid_argument("The column must be an n x 1 matrix");
+  }
+  S21Matrix u(size, 1), v(size, 1);
+  for (int i = 0; i < size; i++) {
+    u.matrix_[i][0] = values.matrix_[i][0] - matrix_.matrix_[i][col];
+  }
+  v.matrix_[col][0] = 1;
+  RankUpdate(u, v);
+}
+
+void S21InverseTracker::RankUpdate(const S21Matrix &u, const S21Matrix &v) {
+  const int size = matrix_.rows_, rank = u.cols_;
+  if (u.rows_ != size || v.rows_ != size || v.cols_ != rank) {
+    throw std::invalid_argument("U and V must both be n x k matrices");
+  }
+  S21Matrix v_transposed = v.Transpose();
+  S21Matrix inverse_u(size, rank), v_inverse(rank, size);
+  S21Matrix::MultiplyInto(inverse_, u, inverse_u);
+  S21Matrix::MultiplyInto(v_transposed, inverse_, v_inverse);
+
+  // Capacitance matrix I + V^T A^-1 U: its determinant scales det(A) and
+  // its inverse gives A'^-1 = A^-1 - A^-1 U C^-1 V^T A^-1.
+  S21Matrix capacitance(rank, rank);
+  S21Matrix::MultiplyInto(v_transposed, inverse_u, capacitance);
+  for (int i = 0; i < rank; i++) {
+    capacitance.matrix_[i][i] += 1;
+  }
+  std::vector<int> pivots;
+  const int sign = capacitance.LuDecompose(pivots);
+  double scale = sign;
+  for (int i = 0; sign && i < rank; i++) {
+    scale *= capacitance.matrix_[i][i];
+  }
+
+  S21Matrix updated(matrix_);
+  updated.BeginWrite();
+  for (int i = 0; i < size; i++) {
+    for (int j = 0; j < size; j++) {
+      double sum = 0;
+      for (int k = 0; k < rank; k++) {
+        sum += u.matrix_[i][k] * v.matrix_[j][k];
+      }
+      updated.matrix_[i][j] += sum;
+    }
+  }
+  // A (near) singular capacitance matrix makes the update unstable, so the
+  // updated matrix is factored from scratch. It only replaces the current
+  // state if that factorization succeeds.
+  if (fabs(scale) <= 1.0e-12) {
+    Factor(updated);
+    return;
+  }
+  capacitance.LuSolve(pivots, v_inverse);
+  S21Matrix correction(size, size);
+  S21Matrix::MultiplyInto(inverse_u, v_inverse, correction);
+  inverse_.SubMatrix(correction);
+  matrix_ = std::move(updated);
+  determinant_ *= scale;
+  ProbeDrift();
+  if (drift_ > drift_threshold_) {
+    Refactor();
+  }
+}
+
+void S21InverseTracker::ProbeDrift() {
+  const int size = matrix_.rows_;
+  std::vector<double> probe(size), solved(size, 0);
+  double probe_norm = 0;
+  for (int i = 0; i < size; i++) {
+    probe[i] = 1.0 + (i % 7) / 7.0;
+    probe_norm = std::max(probe_norm, probe[i]);
+  }
+  for (int i = 0; i < size; i++) {
+    for (int j = 0; j < size; j++) {
+      solved[i] += inverse_.matrix_[i][j] * probe[j];
+    }
+  }
+  double residual = 0, matrix_norm = 0, solved_norm = 0;
+  for (int i = 0; i < size; i++) {
+    double row = -probe[i], row_norm = 0;
+    for (int j = 0; j < size; j++) {
+      row += matrix_.matrix_[i][j] * solved[j];
+      row_norm += fabs(matrix_.matrix_[i][j]);
+    }
+    residual = std::max(residual, fabs(row));
+    matrix_norm = std::max(matrix_norm, row_norm);
+    solved_norm = std::max(solved_norm, fabs(solved[i]));
+  }
+  drift_ = residual / (matrix_norm * solved_norm + probe_norm);
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "s21_matrix_oop.h"
+
+// Keeps the inverse and the determinant of a square matrix up to date under
+// rank-k updates A += U * V^T (Sherman-Morrison-Woodbury and the matrix
+// determinant lemma), O(n^2 k) per update instead of O(n^3). After every
+// update the drift |A * A^-1 * x - x| / (|A| * |A^-1 * x| + |x|) is probed in
+// O(n^2) and the state is refactored from scratch once it exceeds the drift
+// threshold. The scaling keeps the drift of an ill-conditioned matrix at
+// rounding level right after a factorization.
+class S21InverseTracker {
+ public:
+  explicit S21InverseTracker(const S21Matrix& matrix,
+                             double drift_threshold = 1e-9);
+
+  const S21Matrix& GetMatrix() const noexcept;
+  const S21Matrix& GetInverse() const noexcept;
+  double GetDeterminant() const noexcept;
+  double GetDrift() const noexcept;
+  double GetDriftThreshold() const noexcept;
+  void SetDriftThreshold(double drift_threshold);
+  int GetRefactorCount() const noexcept;
+
+  void UpdateRow(int row, const S21Matrix& values);
+  void UpdateCol(int col, const S21Matrix& values);
+  void RankUpdate(const S21Matrix& u, const S21Matrix& v);
+  void Refactor();
+
+ private:
+  S21Matrix matrix_;
+  S21Matrix inverse_;
+  double determinant_;
+  double drift_;
+  double drift_threshold_;
+  int refactor_count_;
+
+  void Factor(const S21Matrix& matrix);
+  void ProbeDrift();
+};
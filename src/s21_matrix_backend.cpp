@@ -0,0 +1,109 @@
+#include "s21_matrix_backend.h"
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+#ifdef S21_MATRIX_BLAS
+#include <cblas.h>
+
+extern "C" {
+void dgetrf_(const int *m, const int *n, double *a, const int *lda, int *ipiv,
+             int *info);
+void dgetri_(const int *n, double *a, const int *lda, const int *ipiv,
+             double *work, const int *lwork, int *info);
+}
+#endif
+
+namespace {
+
+std::atomic<int> gemm_threshold{S21BackendThresholds{}.gemm};
+std::atomic<int> lu_threshold{S21BackendThresholds{}.lu};
+std::atomic<int> transpose_threshold{S21BackendThresholds{}.transpose};
+
+#ifdef S21_MATRIX_BLAS
+// LAPACK is column-major, so it sees a row-major matrix as its transpose.
+// det(A^T) = det(A) and inv(A^T) read back row-major is inv(A), so neither
+// needs an explicit transposition. Returns the determinant of the factors.
+double Factor(int size, double *data, std::vector<int> &pivots) {
+  pivots.resize(size);
+  int info = 0;
+  dgetrf_(&size, &size, data, &size, pivots.data(), &info);
+  if (info > 0) return 0;
+  double determinant = 1;
+  for (int i = 0; i < size; i++) {
+    determinant *= data[static_cast<std::size_t>(i) * size + i];
+    if (pivots[i] != i + 1) determinant = -determinant;
+  }
+  return determinant;
+}
+#endif
+
+}  // namespace
+
+bool HasBlasBackend() noexcept {
+#ifdef S21_MATRIX_BLAS
+  return true;
+#else
+  return false;
+#endif
+}
+
+S21BackendThresholds GetBackendThresholds() noexcept {
+  S21BackendThresholds thresholds;
+  thresholds.gemm = gemm_threshold;
+  thresholds.lu = lu_threshold;
+  thresholds.transpose = transpose_threshold;
+  return thresholds;
+}
+
+void SetBackendThresholds(const S21BackendThresholds &thresholds) noexcept {
+  gemm_threshold = thresholds.gemm;
+  lu_threshold = thresholds.lu;
+  transpose_threshold = thresholds.transpose;
+}
+
+#ifdef S21_MATRIX_BLAS
+bool BlasGemm(int rows, int cols, int inner, double alpha, const double *a,
+              bool transpose_a, const double *b, bool transpose_b,
+              double beta, double *c) {
+  if (std::min({rows, cols, inner}) < gemm_threshold) return false;
+  cblas_dgemm(CblasRowMajor, transpose_a ? CblasTrans : CblasNoTrans,
+              transpose_b ? CblasTrans : CblasNoTrans, rows, cols, inner,
+              alpha, a, transpose_a ? rows : inner, b,
+              transpose_b ? inner : cols, beta, c, cols);
+  return true;
+}
+
+bool BlasFactor(int size, double *factors, std::vector<int> &pivots,
+                double *determinant) {
+  if (size < lu_threshold) return false;
+  *determinant = Factor(size, factors, pivots);
+  return true;
+}
+
+void BlasInvertFactored(int size, double *factors,
+                        const std::vector<int> &pivots) {
+  int info = 0, query = -1;
+  double optimal = 0;
+  dgetri_(&size, factors, &size, pivots.data(), &optimal, &query, &info);
+  int work_size = std::max(size, static_cast<int>(optimal));
+  std::vector<double> work(work_size);
+  dgetri_(&size, factors, &size, pivots.data(), work.data(), &work_size,
+          &info);
+}
+
+bool BlasTranspose(int rows, int cols, const double *matrix,
+                   double *transposed) {
+#ifdef OPENBLAS_VERSION
+  if (std::min(rows, cols) < transpose_threshold) return false;
+  cblas_domatcopy(CblasRowMajor, CblasTrans, rows, cols, 1.0, matrix, cols,
+                  transposed, rows);
+  return true;
+#else
+  // Plain CBLAS has no out-of-place transpose.
+  (void)rows, (void)cols, (void)matrix, (void)transposed;
+  return false;
+#endif
+}
+#endif
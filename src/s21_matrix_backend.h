@@ -0,0 +1,34 @@
+#pragma once
+
+#include <vector>
+
+// Optional CBLAS/LAPACK backend, compiled in with -DS21_MATRIX_BLAS (make
+// BLAS=1 when OpenBLAS or BLIS is installed). Problems whose smallest side
+// reaches a threshold are handed to the library; smaller ones, and builds
+// without it, use the built-in kernels.
+struct S21BackendThresholds {
+  int gemm = 128;
+  int lu = 256;
+  int transpose = 1024;
+};
+
+bool HasBlasBackend() noexcept;
+S21BackendThresholds GetBackendThresholds() noexcept;
+void SetBackendThresholds(const S21BackendThresholds& thresholds) noexcept;
+
+#ifdef S21_MATRIX_BLAS
+// Row-major entry points used by S21Matrix. Those returning bool return
+// false, without touching their output, when the problem is below the
+// threshold.
+bool BlasGemm(int rows, int cols, int inner, double alpha, const double* a,
+              bool transpose_a, const double* b, bool transpose_b,
+              double beta, double* c);
+// Replaces a square matrix by its LU factors and pivots in LAPACK's layout.
+bool BlasFactor(int size, double* factors, std::vector<int>& pivots,
+                double* determinant);
+// Replaces factors from BlasFactor with a nonzero determinant by the inverse.
+void BlasInvertFactored(int size, double* factors,
+                        const std::vector<int>& pivots);
+bool BlasTranspose(int rows, int cols, const double* matrix,
+                   double* transposed);
+#endif
@@ -1,5 +1,440 @@
 #include "s21_matrix_oop.h"
 
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+
+#include "s21_matrix_backend.h"
+#include "s21_thread_pool.h"
+
+namespace {
+
+constexpr int kTransposeTile = 32;
+constexpr int kTransposeMicro = 4;
+constexpr long kParallelMinElements = 1L << 18;
+constexpr int kCofactorMaxSize = 3;
+constexpr int kLuBlock = 64;
+constexpr int kBlockedLuMinSize = 256;
+
+int ThreadCount(long elements) {
+  if (elements < kParallelMinElements) return 1;
+  return S21ThreadPool::Shared().GetThreads();
+}
+
+// Splits [begin, end) into contiguous chunks and runs function(from, to) on
+// each of them as tasks of the shared pool.
+template <typename Function>
+void ParallelFor(int begin, int end, int threads, Function function) {
+  threads = std::min(threads, end - begin);
+  if (threads <= 1) {
+    if (begin < end) function(begin, end);
+    return;
+  }
+  const int chunk = (end - begin + threads - 1) / threads;
+  S21TaskGraph graph;
+  for (int from = begin; from < end; from += chunk) {
+    const int to = std::min(from + chunk, end);
+    graph.Add([&function, from, to] { function(from, to); });
+  }
+  graph.Run(S21ThreadPool::Shared());
+}
+
+// Computes rows [row_begin, row_end) of C = alpha op(A) op(B) + beta C, where
+// inner is the shared dimension of op(A) and op(B).
+void GemmRows(double alpha, const double *const *a, bool transpose_a,
+              const double *const *b, bool transpose_b, double beta,
+              double *const *c, int row_begin, int row_end, int cols,
+              int inner) {
+  // With both operands transposed, column i of A is gathered once per row
+  // of C so that the dot products below run with unit stride.
+  std::vector<double> a_column(transpose_a && transpose_b ? inner : 0);
+  for (int i = row_begin; i < row_end; i++) {
+    double *row = c[i];
+    if (beta == 0) {
+      std::fill(row, row + cols, 0.0);
+    } else if (beta != 1) {
+      for (int j = 0; j < cols; j++) {
+        row[j] *= beta;
+      }
+    }
+    if (!transpose_b) {
+      for (int k = 0; k < inner; k++) {
+        const double factor = alpha * (transpose_a ? a[k][i] : a[i][k]);
+        const double *b_row = b[k];
+        for (int j = 0; j < cols; j++) {
+          row[j] += factor * b_row[j];
+        }
+      }
+    } else {
+      if (transpose_a) {
+        for (int k = 0; k < inner; k++) {
+          a_column[k] = a[k][i];
+        }
+      }
+      const double *a_row = transpose_a ? a_column.data() : a[i];
+      for (int j = 0; j < cols; j++) {
+        const double *b_row = b[j];
+        double sum = 0;
+        for (int k = 0; k < inner; k++) {
+          sum += a_row[k] * b_row[k];
+        }
+        row[j] += alpha * sum;
+      }
+    }
+  }
+}
+
+// Factors columns [col_begin, col_end) of rows [col_begin, size) with partial
+// pivoting. Row swaps are applied to the panel columns only. Returns the sign
+// of the permutation, or 0 if a pivot was zero.
+int FactorPanel(double *const *data, int size, int col_begin, int col_end,
+                int *pivots) noexcept {
+  int sign = 1;
+  for (int k = col_begin; k < col_end; k++) {
+    int pivot = k;
+    for (int i = k + 1; i < size; i++) {
+      if (fabs(data[i][k]) > fabs(data[pivot][k])) pivot = i;
+    }
+    if (data[pivot][k] == 0) {
+      pivots[k] = k;
+      sign = 0;
+      continue;
+    }
+    pivots[k] = pivot;
+    if (pivot != k) {
+      std::swap_ranges(data[pivot] + col_begin, data[pivot] + col_end,
+                       data[k] + col_begin);
+      sign = -sign;
+    }
+    const double *pivot_row = data[k];
+    for (int i = k + 1; i < size; i++) {
+      double *row = data[i];
+      const double factor = row[k] / pivot_row[k];
+      row[k] = factor;
+      for (int j = k + 1; j < col_end; j++) {
+        row[j] -= factor * pivot_row[j];
+      }
+    }
+  }
+  return sign;
+}
+
+// Brings block column [block_begin, block_end) up to date with the factored
+// panel [col_begin, col_end): row swaps, triangular solve with the unit lower
+// diagonal block, then the trailing update below it.
+void UpdateBlockColumn(double *const *data, int size, int col_begin,
+                       int col_end, int block_begin, int block_end,
+                       const int *pivots) noexcept {
+  for (int k = col_begin; k < col_end; k++) {
+    if (pivots[k] != k) {
+      std::swap_ranges(data[k] + block_begin, data[k] + block_end,
+                       data[pivots[k]] + block_begin);
+    }
+  }
+  for (int i = col_begin + 1; i < size; i++) {
+    double *row = data[i];
+    const int last = std::min(i, col_end);
+    for (int k = col_begin; k < last; k++) {
+      const double factor = row[k];
+      const double *pivot_row = data[k];
+      for (int j = block_begin; j < block_end; j++) {
+        row[j] -= factor * pivot_row[j];
+      }
+    }
+  }
+}
+
+// Right-looking blocked LU. Panel k and the updates of the block columns to
+// its right are tasks; the update of block column k + 1 is queued first so
+// the next panel can start while the rest of the trailing matrix is updated.
+int BlockedLu(double *const *data, int size, int *pivots) {
+  const int blocks = (size + kLuBlock - 1) / kLuBlock;
+  std::vector<int> signs(blocks, 1), last_update(blocks, -1);
+  S21TaskGraph graph;
+  for (int k = 0; k < blocks; k++) {
+    const int col_begin = k * kLuBlock;
+    const int col_end = std::min(col_begin + kLuBlock, size);
+    std::vector<int> dependencies;
+    if (last_update[k] >= 0) dependencies.push_back(last_update[k]);
+    const int panel = graph.Add(
+        [data, size, col_begin, col_end, pivots, &signs, k] {
+          signs[k] = FactorPanel(data, size, col_begin, col_end, pivots);
+        },
+        dependencies);
+    for (int j = k + 1; j < blocks; j++) {
+      const int block_begin = j * kLuBlock;
+      const int block_end = std::min(block_begin + kLuBlock, size);
+      dependencies.assign(1, panel);
+      if (last_update[j] >= 0) dependencies.push_back(last_update[j]);
+      last_update[j] = graph.Add(
+          [=] {
+            UpdateBlockColumn(data, size, col_begin, col_end, block_begin,
+                              block_end, pivots);
+          },
+          dependencies);
+    }
+  }
+  graph.Run(S21ThreadPool::Shared());
+
+  // The swaps of each panel still have to reach the columns left of it.
+  int sign = 1;
+  for (int k = 0; k < blocks; k++) {
+    const int col_begin = k * kLuBlock;
+    const int col_end = std::min(col_begin + kLuBlock, size);
+    for (int i = col_begin; i < col_end; i++) {
+      if (pivots[i] != i) {
+        std::swap_ranges(data[i], data[i] + col_begin, data[pivots[i]]);
+      }
+    }
+    sign *= signs[k];
+  }
+  return sign;
+}
+
+// Solves L U X = B in place for the columns [col_begin, col_end) of B, whose
+// rows are already permuted.
+void SolveColumns(const double *const *lu, double *const *rhs, int size,
+                  int col_begin, int col_end) noexcept {
+  for (int i = 0; i < size; i++) {
+    double *row = rhs[i];
+    for (int k = 0; k < i; k++) {
+      const double factor = lu[i][k];
+      const double *solved = rhs[k];
+      for (int j = col_begin; j < col_end; j++) {
+        row[j] -= factor * solved[j];
+      }
+    }
+  }
+  for (int i = size - 1; i >= 0; i--) {
+    double *row = rhs[i];
+    for (int k = i + 1; k < size; k++) {
+      const double factor = lu[i][k];
+      const double *solved = rhs[k];
+      for (int j = col_begin; j < col_end; j++) {
+        row[j] -= factor * solved[j];
+      }
+    }
+    const double diagonal = lu[i][i];
+    for (int j = col_begin; j < col_end; j++) {
+      row[j] /= diagonal;
+    }
+  }
+}
+
+// Writes the transpose of src[row_begin, row_end) x [col_begin, col_end) into
+// dst, going through 4x4 register blocks so loads and stores stay unit-stride.
+void TransposeTile(double *const *src, double *const *dst, int row_begin,
+                   int row_end, int col_begin, int col_end) {
+  int i = row_begin;
+  for (; i + kTransposeMicro <= row_end; i += kTransposeMicro) {
+    int j = col_begin;
+    for (; j + kTransposeMicro <= col_end; j += kTransposeMicro) {
+      double block[kTransposeMicro][kTransposeMicro];
+      for (int r = 0; r < kTransposeMicro; r++) {
+        for (int c = 0; c < kTransposeMicro; c++) {
+          block[c][r] = src[i + r][j + c];
+        }
+      }
+      for (int c = 0; c < kTransposeMicro; c++) {
+        for (int r = 0; r < kTransposeMicro; r++) {
+          dst[j + c][i + r] = block[c][r];
+        }
+      }
+    }
+    for (; j < col_end; j++) {
+      for (int r = 0; r < kTransposeMicro; r++) {
+        dst[j][i + r] = src[i + r][j];
+      }
+    }
+  }
+  for (; i < row_end; i++) {
+    for (int j = col_begin; j < col_end; j++) {
+      dst[j][i] = src[i][j];
+    }
+  }
+}
+
+// Cache-oblivious transpose: halves the longer side until a tile fits.
+void TransposeRecursive(double *const *src, double *const *dst, int row_begin,
+                        int row_end, int col_begin, int col_end) {
+  const int rows = row_end - row_begin, cols = col_end - col_begin;
+  if (rows <= kTransposeTile && cols <= kTransposeTile) {
+    TransposeTile(src, dst, row_begin, row_end, col_begin, col_end);
+  } else if (rows >= cols) {
+    const int middle = row_begin + rows / 2;
+    TransposeRecursive(src, dst, row_begin, middle, col_begin, col_end);
+    TransposeRecursive(src, dst, middle, row_end, col_begin, col_end);
+  } else {
+    const int middle = col_begin + cols / 2;
+    TransposeRecursive(src, dst, row_begin, row_end, col_begin, middle);
+    TransposeRecursive(src, dst, row_begin, row_end, middle, col_end);
+  }
+}
+
+// Swaps the tiles of block row `block` with the matching tiles of block
+// column `block`, the diagonal tile with itself.
+void TransposeBlockRowInPlace(double *const *data, int size, int block) {
+  const int row_begin = block * kTransposeTile;
+  const int row_end = std::min(row_begin + kTransposeTile, size);
+  for (int i = row_begin; i < row_end; i++) {
+    for (int j = i + 1; j < row_end; j++) {
+      std::swap(data[i][j], data[j][i]);
+    }
+  }
+  for (int col_begin = row_end; col_begin < size; col_begin += kTransposeTile) {
+    const int col_end = std::min(col_begin + kTransposeTile, size);
+    for (int i = row_begin; i < row_end; i++) {
+      for (int j = col_begin; j < col_end; j++) {
+        std::swap(data[i][j], data[j][i]);
+      }
+    }
+  }
+}
+
+constexpr std::size_t kTextChunk = 1 << 22;
+
+using File = std::unique_ptr<std::FILE, decltype(&std::fclose)>;
+
+File OpenFile(const std::string &path, const char *mode) {
+  File file(std::fopen(path.c_str(), mode), &std::fclose);
+  if (!file) {
+    throw std::runtime_error("Cannot open file " + path);
+  }
+  return file;
+}
+
+std::string ReadTextFile(const std::string &path) {
+  File file = OpenFile(path, "rb");
+  long known_size = -1;
+  if (std::fseek(file.get(), 0, SEEK_END) == 0) {
+    known_size = std::ftell(file.get());
+    std::rewind(file.get());
+  }
+  // A regular file is read in one go into a buffer of its exact size. Pipes
+  // and pseudo-files report no useful size and are read in chunks instead.
+  std::string text;
+  std::size_t size = 0;
+  if (known_size > 0) {
+    text.resize(static_cast<std::size_t>(known_size));
+    size = std::fread(&text[0], 1, text.size(), file.get());
+  } else {
+    std::size_t read = 0;
+    do {
+      text.resize(size + kTextChunk);
+      read = std::fread(&text[size], 1, kTextChunk, file.get());
+      size += read;
+    } while (read == kTextChunk);
+  }
+  if (std::ferror(file.get())) {
+    throw std::runtime_error("Cannot read file " + path);
+  }
+  text.resize(size);
+  return text;
+}
+
+bool IsTextBlank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+bool IsTextDelimiter(char c) { return c == ',' || c == ';'; }
+
+bool IsTextSeparator(char c) { return IsTextBlank(c) || IsTextDelimiter(c); }
+
+const char *SkipTextBlanks(const char *begin, const char *end) {
+  return std::find_if_not(begin, end, IsTextBlank);
+}
+
+// Calls field(field_begin, field_end) for every field of the line [begin,
+// end). Runs of blanks form one separator, while a comma or semicolon ends
+// exactly one field, so "1,,2" has an empty field. Returns false on an empty
+// field or as soon as field returns false.
+template <typename Field>
+bool ForEachTextField(const char *begin, const char *end, Field field) {
+  begin = SkipTextBlanks(begin, end);
+  while (begin != end) {
+    const char *field_end = std::find_if(begin, end, IsTextSeparator);
+    if (field_end == begin || !field(begin, field_end)) return false;
+    begin = SkipTextBlanks(field_end, end);
+    if (begin != end && IsTextDelimiter(*begin)) {
+      begin = SkipTextBlanks(begin + 1, end);
+      if (begin == end) return false;
+    }
+  }
+  return true;
+}
+
+// Returns the number of fields of the line [begin, end), or 0 if one of them
+// is empty.
+int CountTextFields(const char *begin, const char *end) {
+  int count = 0;
+  const bool valid =
+      ForEachTextField(begin, end, [&count](const char *, const char *) {
+        count++;
+        return true;
+      });
+  return valid ? count : 0;
+}
+
+// Parses exactly `cols` numbers of the line [begin, end) into row. A leading
+// '+' is accepted as iostream does, which from_chars alone would reject.
+bool ParseTextLine(const char *begin, const char *end, double *row,
+                   int cols) {
+  int count = 0;
+  const bool valid = ForEachTextField(
+      begin, end,
+      [row, cols, &count](const char *field, const char *field_end) {
+        if (count == cols) return false;
+        if (*field == '+' && field + 1 != field_end && field[1] != '-') {
+          field++;
+        }
+        const auto [next, error] = std::from_chars(field, field_end,
+                                                   row[count]);
+        count++;
+        return error == std::errc() && next == field_end;
+      });
+  return valid && count == cols;
+}
+
+}  // namespace
+
+// LU factors with partial pivoting from the built-in kernels or, above the
+// backend threshold, from LAPACK. The two layouts differ, so each is inverted
+// by its own routine.
+struct S21Matrix::Factorization {
+  explicit Factorization(const S21Matrix &matrix)
+      : lu(matrix.rows_, matrix.cols_) {
+    std::copy(matrix.begin(), matrix.end(), lu.data_.get());
+#ifdef S21_MATRIX_BLAS
+    blas = BlasFactor(lu.rows_, lu.data_.get(), pivots, &determinant);
+    if (blas) return;
+#endif
+    const int sign = lu.LuDecompose(pivots);
+    determinant = sign;
+    for (int i = 0; sign && i < lu.rows_; i++) {
+      determinant *= lu.matrix_[i][i];
+    }
+  }
+
+  // Writes the inverse into inversed. The determinant must not be 0.
+  void Invert(S21Matrix &inversed) const {
+#ifdef S21_MATRIX_BLAS
+    if (blas) {
+      std::copy(lu.begin(), lu.end(), inversed.data_.get());
+      inversed.version_++;
+      BlasInvertFactored(lu.rows_, inversed.data_.get(), pivots);
+      return;
+    }
+#endif
+    inversed.FillIdentity();
+    lu.LuSolve(pivots, inversed);
+  }
+
+  S21Matrix lu;
+  std::vector<int> pivots;
+  double determinant = 0;
+  bool blas = false;
+};
+
 S21Matrix::S21Matrix() noexcept : rows_{3}, cols_{3}, matrix_{} {
   ConstructMatrix();
 }
@@ -14,40 +449,66 @@ S21Matrix::S21Matrix(int rows, int cols) {
 }
 
 void S21Matrix::ConstructMatrix() {
+  data_.reset(new double[static_cast<std::size_t>(rows_) * cols_]());
   matrix_ = new double *[rows_];
+  LinkRows();
+}
+
+void S21Matrix::LinkRows() noexcept {
   for (int i = 0; i < rows_; i++) {
-    matrix_[i] = new double[cols_];
-    for (int j = 0; j < cols_; j++) {
-      matrix_[i][j] = 0;
-    }
+    matrix_[i] = data_.get() + static_cast<std::size_t>(i) * cols_;
   }
 }
 
 void S21Matrix::DestructMatrix() noexcept {
-  for (int i = 0; i < rows_; i++) {
-    delete[] matrix_[i];
-  }
   delete[] matrix_;
+  data_.reset();
   matrix_ = {};
   rows_ = {};
   cols_ = {};
 }
 
 S21Matrix::S21Matrix(const S21Matrix &other)
-    : rows_(other.rows_), cols_(other.cols_) {
+    : rows_(other.rows_),
+      cols_(other.cols_),
+      copy_on_write_(other.copy_on_write_),
+      version_(other.version_),
+      cache_(other.CopyCache()) {
   if (&other == this) {
     throw std::logic_error("Self-copying is not allowed");
   }
-  CopyMatrix(other);
+  if (copy_on_write_) {
+    ShareMatrix(other);
+  } else {
+    CopyMatrix(other);
+  }
 }
 
 void S21Matrix::CopyMatrix(const S21Matrix &other) {
   ConstructMatrix();
-  for (int i = 0; i < rows_; i++) {
-    for (int j = 0; j < cols_; j++) {
-      matrix_[i][j] = other(i, j);
-    }
-  }
+  std::copy(other.data_.get(),
+            other.data_.get() + static_cast<std::size_t>(rows_) * cols_,
+            data_.get());
+}
+
+void S21Matrix::ShareMatrix(const S21Matrix &other) {
+  matrix_ = new double *[rows_];
+  data_ = other.data_;
+  LinkRows();
+}
+
+void S21Matrix::BeginWrite() {
+  Detach();
+  version_++;
+}
+
+void S21Matrix::Detach() {
+  if (!copy_on_write_ || data_.use_count() <= 1) return;
+  const std::size_t size = static_cast<std::size_t>(rows_) * cols_;
+  std::shared_ptr<double[]> own(new double[size]);
+  std::copy(data_.get(), data_.get() + size, own.get());
+  data_ = std::move(own);
+  LinkRows();
 }
 
 S21Matrix::S21Matrix(S21Matrix &&other) noexcept {
@@ -55,6 +516,10 @@ S21Matrix::S21Matrix(S21Matrix &&other) noexcept {
     rows_ = std::exchange(other.rows_, 0);
     cols_ = std::exchange(other.cols_, 0);
     matrix_ = std::exchange(other.matrix_, nullptr);
+    data_ = std::move(other.data_);
+    copy_on_write_ = other.copy_on_write_;
+    version_ = other.version_;
+    cache_ = std::move(other.cache_);
   }
 }
 
@@ -64,6 +529,13 @@ int S21Matrix::GetRows() const noexcept { return rows_; }
 
 int S21Matrix::GetCols() const noexcept { return cols_; }
 
+bool S21Matrix::IsCopyOnWrite() const noexcept { return copy_on_write_; }
+
+void S21Matrix::SetCopyOnWrite(bool enabled) {
+  Detach();
+  copy_on_write_ = enabled;
+}
+
 void S21Matrix::SetRows(int rows) {
   if (rows < 1) {
     throw std::invalid_argument("Rows must be at least 1");
@@ -72,6 +544,7 @@ void S21Matrix::SetRows(int rows) {
   double edge = rows_;
   if (rows < rows_) edge = rows;
   FillMatrix(new_matrix, edge, cols_);
+  new_matrix.copy_on_write_ = copy_on_write_;
   *this = std::move(new_matrix);
 }
 
@@ -83,14 +556,14 @@ void S21Matrix::SetCols(int cols) {
   double edge = cols_;
   if (cols < cols_) edge = cols;
   FillMatrix(new_matrix, rows_, edge);
+  new_matrix.copy_on_write_ = copy_on_write_;
   *this = std::move(new_matrix);
 }
 
 void S21Matrix::FillMatrix(S21Matrix &new_matrix, int rows, int cols) {
+  new_matrix.BeginWrite();
   for (int i = 0; i < rows; i++) {
-    for (int j = 0; j < cols; j++) {
-      new_matrix(i, j) = matrix_[i][j];
-    }
+    std::copy(matrix_[i], matrix_[i] + cols, new_matrix.matrix_[i]);
   }
 }
 
@@ -98,33 +571,18 @@ bool S21Matrix::EqMatrix(const S21Matrix &other) const noexcept {
   if (rows_ != other.rows_ || cols_ != other.cols_) {
     return false;
   }
-  for (int i = 0; i < rows_; i++) {
-    for (int j = 0; j < cols_; j++) {
-      if (fabs(matrix_[i][j] - other(i, j)) >= 1e-07) {
-        return false;
-      }
-    }
+  const double *left = data_.get(), *right = other.data_.get();
+  const std::size_t size = static_cast<std::size_t>(rows_) * cols_;
+  bool equal = true;
+  for (std::size_t i = 0; i < size; i++) {
+    equal &= !(fabs(left[i] - right[i]) >= 1e-07);
   }
-  return true;
+  return equal;
 }
 
-void S21Matrix::SumMatrix(const S21Matrix &other) {
-  CheckIfMatricesSizesAreEqual(other);
-  for (int i = 0; i < rows_; i++) {
-    for (int j = 0; j < cols_; j++) {
-      matrix_[i][j] += other(i, j);
-    }
-  }
-}
+void S21Matrix::SumMatrix(const S21Matrix &other) { Axpy(1, other, *this); }
 
-void S21Matrix::SubMatrix(const S21Matrix &other) {
-  CheckIfMatricesSizesAreEqual(other);
-  for (int i = 0; i < rows_; i++) {
-    for (int j = 0; j < cols_; j++) {
-      matrix_[i][j] -= other(i, j);
-    }
-  }
-}
+void S21Matrix::SubMatrix(const S21Matrix &other) { Axpy(-1, other, *this); }
 
 void S21Matrix::CheckIfMatricesSizesAreEqual(const S21Matrix &other) const {
   if (rows_ != other.rows_ || cols_ != other.cols_) {
@@ -133,13 +591,7 @@ void S21Matrix::CheckIfMatricesSizesAreEqual(const S21Matrix &other) const {
   }
 }
 
-void S21Matrix::MulNumber(const double num) noexcept {
-  for (int i = 0; i < rows_; i++) {
-    for (int j = 0; j < cols_; j++) {
-      matrix_[i][j] *= num;
-    }
-  }
-}
+void S21Matrix::MulNumber(const double num) { Scal(num, *this); }
 
 void S21Matrix::MulMatrix(const S21Matrix &other) {
   if (cols_ != other.rows_) {
@@ -148,15 +600,154 @@ void S21Matrix::MulMatrix(const S21Matrix &other) {
         "of rows in the second");
   }
   S21Matrix res(rows_, other.cols_);
+  res.copy_on_write_ = copy_on_write_;
+  MultiplyInto(*this, other, res);
+  *this = std::move(res);
+}
+
+void S21Matrix::MultiplyInto(const S21Matrix &left, const S21Matrix &right,
+                             S21Matrix &result) {
+  result.version_++;
+#ifdef S21_MATRIX_BLAS
+  if (BlasGemm(result.rows_, result.cols_, left.cols_, 1, left.data_.get(),
+               false, right.data_.get(), false, 0, result.data_.get())) {
+    return;
+  }
+#endif
+  const double *const *a = left.matrix_;
+  const double *const *b = right.matrix_;
+  double *const *c = result.matrix_;
+  const int cols = result.cols_, inner = left.cols_;
+  ParallelFor(0, result.rows_,
+              ThreadCount(static_cast<long>(result.rows_) * cols * inner),
+              [a, b, c, cols, inner](int from, int to) {
+                GemmRows(1, a, false, b, false, 0, c, from, to, cols, inner);
+              });
+}
+
+S21Matrix S21Matrix::Pow(unsigned int power) const {
+  CheckIfMatrixIsSquare();
+  S21Matrix result(rows_, cols_), base(*this), workspace(rows_, cols_);
+  base.Detach();
+  result.FillIdentity();
+  while (power) {
+    if (power & 1u) {
+      MultiplyInto(result, base, workspace);
+      result.Swap(workspace);
+    }
+    power >>= 1;
+    if (power) {
+      MultiplyInto(base, base, workspace);
+      base.Swap(workspace);
+    }
+  }
+  // The swaps above move the mode along with the buffers.
+  result.copy_on_write_ = copy_on_write_;
+  return result;
+}
+
+S21Matrix S21Matrix::Exp() const {
+  CheckIfMatrixIsSquare();
+  // Scale A by 2^-s so that its infinity norm is at most 1/2, where the
+  // (6, 6) Pade approximant is accurate to double precision.
+  double norm = 0;
   for (int i = 0; i < rows_; i++) {
-    for (int j = 0; j < other.cols_; j++) {
-      res(i, j) = 0;
-      for (int k = 0; k < cols_; k++) {
-        res(i, j) += matrix_[i][k] * other.matrix_[k][j];
+    double row_sum = 0;
+    for (int j = 0; j < cols_; j++) {
+      row_sum += fabs(matrix_[i][j]);
+    }
+    if (!std::isfinite(row_sum)) {
+      throw std::logic_error("The matrix exponential cannot be computed");
+    }
+    norm = std::max(norm, row_sum);
+  }
+  int squarings = 0;
+  if (norm > 0.5) {
+    squarings = std::max(0, static_cast<int>(ceil(log2(norm / 0.5))));
+  }
+  S21Matrix scaled(*this);
+  scaled.MulNumber(ldexp(1.0, -squarings));
+
+  constexpr int kPadeDegree = 6;
+  S21Matrix numerator(rows_, cols_), denominator(rows_, cols_);
+  S21Matrix power(scaled), workspace(rows_, cols_);
+  power.Detach();
+  numerator.FillIdentity();
+  denominator.FillIdentity();
+  double coefficient = 1;
+  for (int k = 1; k <= kPadeDegree; k++) {
+    coefficient *= static_cast<double>(kPadeDegree - k + 1) /
+                   (k * (2 * kPadeDegree - k + 1));
+    const double sign = (k % 2) ? -1 : 1;
+    for (int i = 0; i < rows_; i++) {
+      for (int j = 0; j < cols_; j++) {
+        numerator.matrix_[i][j] += coefficient * power.matrix_[i][j];
+        denominator.matrix_[i][j] += sign * coefficient * power.matrix_[i][j];
       }
     }
+    if (k < kPadeDegree) {
+      MultiplyInto(power, scaled, workspace);
+      power.Swap(workspace);
+    }
   }
-  *this = std::move(res);
+
+  std::vector<int> pivots;
+  if (!denominator.LuDecompose(pivots)) {
+    throw std::logic_error("The matrix exponential cannot be computed");
+  }
+  denominator.LuSolve(pivots, numerator);
+  for (int i = 0; i < squarings; i++) {
+    MultiplyInto(numerator, numerator, workspace);
+    numerator.Swap(workspace);
+  }
+  numerator.copy_on_write_ = copy_on_write_;
+  return numerator;
+}
+
+int S21Matrix::LuDecompose(std::vector<int> &pivots) {
+  version_++;
+  pivots.assign(rows_, 0);
+  if (rows_ < kBlockedLuMinSize) {
+    return FactorPanel(matrix_, rows_, 0, cols_, pivots.data());
+  }
+  return BlockedLu(matrix_, rows_, pivots.data());
+}
+
+void S21Matrix::LuSolve(const std::vector<int> &pivots,
+                        S21Matrix &rhs) const {
+  rhs.version_++;
+  for (int k = 0; k < rows_; k++) {
+    if (pivots[k] != k) {
+      double *row = rhs.matrix_[k];
+      std::swap_ranges(row, row + rhs.cols_, rhs.matrix_[pivots[k]]);
+    }
+  }
+  const double *const *lu = matrix_;
+  double *const *solved = rhs.matrix_;
+  const int size = rows_;
+  ParallelFor(0, rhs.cols_, ThreadCount(static_cast<long>(size) * rhs.cols_),
+              [lu, solved, size](int from, int to) {
+                SolveColumns(lu, solved, size, from, to);
+              });
+}
+
+void S21Matrix::FillIdentity() noexcept {
+  version_++;
+  for (int i = 0; i < rows_; i++) {
+    for (int j = 0; j < cols_; j++) {
+      matrix_[i][j] = (i == j) ? 1 : 0;
+    }
+  }
+}
+
+void S21Matrix::Swap(S21Matrix &other) noexcept {
+  std::swap(rows_, other.rows_);
+  std::swap(cols_, other.cols_);
+  std::swap(matrix_, other.matrix_);
+  std::swap(data_, other.data_);
+  std::swap(copy_on_write_, other.copy_on_write_);
+  std::swap(version_, other.version_);
+  std::swap(cache_, other.cache_);
 }
 
 S21Matrix S21Matrix::CalcComplements() const {
@@ -173,14 +764,40 @@ S21Matrix S21Matrix::CalcComplements() const {
 
 S21Matrix S21Matrix::Transpose() const {
   S21Matrix transposed(cols_, rows_);
-  for (int i = 0; i < transposed.rows_; i++) {
-    for (int j = 0; j < transposed.cols_; j++) {
-      transposed(i, j) = matrix_[j][i];
-    }
+#ifdef S21_MATRIX_BLAS
+  if (BlasTranspose(rows_, cols_, data_.get(), transposed.data_.get())) {
+    return transposed;
   }
+#endif
+  double *const *src = matrix_;
+  double *const *dst = transposed.matrix_;
+  const int cols = cols_;
+  ParallelFor(0, rows_, ThreadCount(static_cast<long>(rows_) * cols_),
+              [src, dst, cols](int from, int to) {
+                TransposeRecursive(src, dst, from, to, 0, cols);
+              });
   return transposed;
 }
 
+void S21Matrix::TransposeInPlace() {
+  CheckIfMatrixIsSquare();
+  BeginWrite();
+  double *const *data = matrix_;
+  const int size = rows_;
+  const int blocks = (size + kTransposeTile - 1) / kTransposeTile;
+  // Block row b does blocks - b tiles, so b is paired with blocks - 1 - b to
+  // give every chunk the same amount of work.
+  ParallelFor(0, (blocks + 1) / 2, ThreadCount(static_cast<long>(size) * size),
+              [data, size, blocks](int from, int to) {
+                for (int pair = from; pair < to; pair++) {
+                  TransposeBlockRowInPlace(data, size, pair);
+                  if (blocks - 1 - pair != pair) {
+                    TransposeBlockRowInPlace(data, size, blocks - 1 - pair);
+                  }
+                }
+              });
+}
+
 void S21Matrix::CheckIfMatrixIsSquare() const {
   if (rows_ != cols_) {
     throw std::logic_error("The matrix is not a square matrix");
@@ -216,7 +833,72 @@ void S21Matrix::FindMinor(S21Matrix &minor, int row, int col) const noexcept {
 
 double S21Matrix::Determinant() const {
   CheckIfMatrixIsSquare();
-  return DeterminantHandle();
+  {
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    SyncCache();
+    (cache_.has_determinant ? cache_stats_.hits : cache_stats_.misses)++;
+    if (cache_.has_determinant) return cache_.determinant;
+  }
+  // Cofactor expansion is cheap for tiny matrices and exact for integers.
+  // Larger ones keep their factors for a following InverseMatrix.
+  double determinant = 0;
+  std::shared_ptr<const Factorization> factorization;
+  if (rows_ <= kCofactorMaxSize) {
+    determinant = DeterminantHandle();
+  } else {
+    factorization = std::make_shared<const Factorization>(*this);
+    determinant = factorization->determinant;
+  }
+  StoreCache(determinant, std::move(factorization), nullptr);
+  return determinant;
+}
+
+S21Matrix::Cache S21Matrix::CopyCache() const {
+  std::lock_guard<std::mutex> lock(cache_mutex_);
+  return cache_;
+}
+
+// Must be called with cache_mutex_ held.
+void S21Matrix::SyncCache() const noexcept {
+  if (cache_.version != version_) {
+    cache_ = Cache{};
+    cache_.version = version_;
+  }
+}
+
+// Results are computed without holding the lock, so two threads that miss
+// at the same time may both compute them; the first inverse stored wins.
+// Once there is an inverse the factors are not needed any more.
+std::shared_ptr<const S21Matrix> S21Matrix::StoreCache(
+    double determinant, std::shared_ptr<const Factorization> factorization,
+    std::shared_ptr<const S21Matrix> inverse) const {
+  std::lock_guard<std::mutex> lock(cache_mutex_);
+  SyncCache();
+  cache_.determinant = determinant;
+  cache_.has_determinant = true;
+  if (inverse && !cache_.inverse) cache_.inverse = std::move(inverse);
+  if (cache_.inverse) {
+    cache_.factorization.reset();
+  } else if (factorization) {
+    cache_.factorization = std::move(factorization);
+  }
+  return cache_.inverse;
+}
+
+void S21Matrix::ClearCache() const {
+  std::lock_guard<std::mutex> lock(cache_mutex_);
+  cache_ = Cache{};
+  cache_.version = version_;
+}
+
+S21Matrix::CacheStats S21Matrix::GetCacheStats() const {
+  std::lock_guard<std::mutex> lock(cache_mutex_);
+  return cache_stats_;
+}
+
+void S21Matrix::ResetCacheStats() {
+  std::lock_guard<std::mutex> lock(cache_mutex_);
+  cache_stats_ = CacheStats{};
 }
 
 double S21Matrix::DeterminantHandle() const {
@@ -235,13 +917,39 @@ double S21Matrix::DeterminantHandle() const {
 }
 
 S21Matrix S21Matrix::InverseMatrix() const {
-  const double determinant = Determinant();
-  if (fabs(determinant) <= 1.0e-7) {
-    throw std::logic_error("The determinant of a matrix cannot be 0");
+  CheckIfMatrixIsSquare();
+  Cache cache;
+  {
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    SyncCache();
+    (cache_.inverse ? cache_stats_.hits : cache_stats_.misses)++;
+    cache = cache_;
+  }
+  std::shared_ptr<const S21Matrix> inverse = std::move(cache.inverse);
+  if (!inverse) {
+    std::shared_ptr<const Factorization> factorization =
+        std::move(cache.factorization);
+    if (!factorization) {
+      factorization = std::make_shared<const Factorization>(*this);
+    }
+    double determinant = cache.determinant;
+    if (!cache.has_determinant) {
+      determinant = rows_ <= kCofactorMaxSize ? DeterminantHandle()
+                                              : factorization->determinant;
+    }
+    if (fabs(determinant) <= 1.0e-7 || !factorization->determinant) {
+      StoreCache(determinant, nullptr, nullptr);
+      throw std::logic_error("The determinant of a matrix cannot be 0");
+    }
+    auto inversed = std::make_shared<S21Matrix>(rows_, cols_);
+    factorization->Invert(*inversed);
+    inversed->copy_on_write_ = true;
+    inverse = StoreCache(determinant, nullptr, std::move(inversed));
   }
-  S21Matrix inversed = CalcComplements();
-  inversed = inversed.Transpose();
-  inversed *= (1.0 / determinant);
+  // The cached inverse is shared with the result and copied out only when
+  // this matrix is not in copy-on-write mode.
+  S21Matrix inversed(*inverse);
+  inversed.SetCopyOnWrite(copy_on_write_);
   return inversed;
 }
 
@@ -273,14 +981,21 @@ bool S21Matrix::operator==(const S21Matrix &other) const noexcept {
   return EqMatrix(other);
 }
 
+S21Matrix &S21Matrix::operator=(const S21Matrix &other) {
+  if (this == &other) {
+    return *this;
+  }
+  S21Matrix copy(other);
+  Swap(copy);
+  return *this;
+}
+
 S21Matrix &S21Matrix::operator=(S21Matrix &&other) {
   if (this == &other) {
     return *this;
   }
   DestructMatrix();
-  rows_ = other.rows_;
-  cols_ = other.cols_;
-  CopyMatrix(other);
+  Swap(other);
   return *this;
 }
 
@@ -304,13 +1019,181 @@ S21Matrix S21Matrix::operator*=(const double mul) {
   return *this;
 }
 
-double &S21Matrix::operator()(int row, int col) const {
+S21Matrix::ElementRef S21Matrix::operator()(int row, int col) {
+  CheckIfIndexIsOutOfBounds(row, col);
+  return ElementRef(this, row, col);
+}
+
+const double &S21Matrix::operator()(int row, int col) const {
   CheckIfIndexIsOutOfBounds(row, col);
   return matrix_[row][col];
 }
 
+S21Matrix::ElementRef S21Matrix::At(int row, int col) {
+  return (*this)(row, col);
+}
+
+const double &S21Matrix::At(int row, int col) const {
+  return (*this)(row, col);
+}
+
+S21Matrix::RowSpan<double> S21Matrix::Row(int row) {
+  CheckIfIndexIsOutOfBounds(row, 0);
+  BeginWrite();
+  return RowSpan<double>(matrix_[row], cols_);
+}
+
+S21Matrix::RowSpan<const double> S21Matrix::Row(int row) const {
+  CheckIfIndexIsOutOfBounds(row, 0);
+  return RowSpan<const double>(matrix_[row], cols_);
+}
+
+S21Matrix::RowSpan<const double> S21Matrix::CRow(int row) const {
+  return Row(row);
+}
+
+double *S21Matrix::begin() {
+  BeginWrite();
+  return data_.get();
+}
+
+double *S21Matrix::end() {
+  BeginWrite();
+  return data_.get() + static_cast<std::size_t>(rows_) * cols_;
+}
+
+const double *S21Matrix::begin() const noexcept { return data_.get(); }
+
+const double *S21Matrix::end() const noexcept {
+  return data_.get() + static_cast<std::size_t>(rows_) * cols_;
+}
+
+const double *S21Matrix::cbegin() const noexcept { return begin(); }
+
+const double *S21Matrix::cend() const noexcept { return end(); }
+
 void S21Matrix::CheckIfIndexIsOutOfBounds(int row, int col) const {
   if (row < 0 || col < 0 || row >= rows_ || col >= cols_) {
     throw std::out_of_range("Matrix index(es) are out of bounds");
   }
-}
\ No newline at end of file
+}
+
+S21Matrix S21Matrix::FromText(const std::string &path) {
+  const std::string text = ReadTextFile(path);
+  const char *const data = text.data();
+  std::vector<std::pair<const char *, const char *>> lines;
+  for (const char *begin = data, *end = data + text.size(); begin < end;) {
+    const char *line_end = static_cast<const char *>(
+        std::memchr(begin, '\n', static_cast<std::size_t>(end - begin)));
+    if (!line_end) line_end = end;
+    if (std::find_if_not(begin, line_end, IsTextSeparator) != line_end) {
+      lines.emplace_back(begin, line_end);
+    }
+    begin = line_end + 1;
+  }
+  if (lines.empty()) {
+    throw std::invalid_argument("The text does not contain a matrix");
+  }
+  const int rows = static_cast<int>(lines.size());
+  const int cols = CountTextFields(lines[0].first, lines[0].second);
+  if (!cols) {
+    throw std::invalid_argument(
+        "The text is not a rectangular table of numbers");
+  }
+  S21Matrix result(rows, cols);
+  double *const *rows_data = result.matrix_;
+  std::atomic<bool> malformed{false};
+  ParallelFor(0, rows, ThreadCount(static_cast<long>(rows) * cols),
+              [&lines, &malformed, rows_data, cols](int from, int to) {
+                for (int i = from; i < to && !malformed; i++) {
+                  if (!ParseTextLine(lines[i].first, lines[i].second,
+                                     rows_data[i], cols)) {
+                    malformed = true;
+                  }
+                }
+              });
+  if (malformed) {
+    throw std::invalid_argument(
+        "The text is not a rectangular table of numbers");
+  }
+  return result;
+}
+
+void S21Matrix::ToText(const std::string &path, char separator) const {
+  File file = OpenFile(path, "wb");
+  std::string buffer;
+  buffer.reserve(kTextChunk + 64);
+  char number[32];
+  for (int i = 0; i < rows_; i++) {
+    for (int j = 0; j < cols_; j++) {
+      const auto result =
+          std::to_chars(number, number + sizeof(number), matrix_[i][j]);
+      buffer.append(number, result.ptr);
+      buffer.push_back(j + 1 < cols_ ? separator : '\n');
+    }
+    if (buffer.size() >= kTextChunk || i + 1 == rows_) {
+      if (std::fwrite(buffer.data(), 1, buffer.size(), file.get()) !=
+          buffer.size()) {
+        throw std::runtime_error("Cannot write file " + path);
+      }
+      buffer.clear();
+    }
+  }
+  // Buffered data is only written out on close, which the deleter would
+  // report to no one.
+  if (std::fclose(file.release()) != 0) {
+    throw std::runtime_error("Cannot write file " + path);
+  }
+}
+
+void Gemm(double alpha, const S21Matrix &a, S21Op op_a, const S21Matrix &b,
+          S21Op op_b, double beta, S21Matrix &c) {
+  const bool transpose_a = op_a == S21Op::kTranspose;
+  const bool transpose_b = op_b == S21Op::kTranspose;
+  const int rows = transpose_a ? a.cols_ : a.rows_;
+  const int inner = transpose_a ? a.rows_ : a.cols_;
+  const int b_rows = transpose_b ? b.cols_ : b.rows_;
+  const int cols = transpose_b ? b.rows_ : b.cols_;
+  if (inner != b_rows || c.rows_ != rows || c.cols_ != cols) {
+    throw std::invalid_argument(
+        "The sizes of op(A), op(B) and C do not match for op(A) * op(B)");
+  }
+  if (&c == &a || &c == &b) {
+    throw std::invalid_argument("The output matrix cannot be an input");
+  }
+  c.BeginWrite();
+#ifdef S21_MATRIX_BLAS
+  if (BlasGemm(rows, cols, inner, alpha, a.data_.get(), transpose_a,
+               b.data_.get(), transpose_b, beta, c.data_.get())) {
+    return;
+  }
+#endif
+  const double *const *a_rows = a.matrix_;
+  const double *const *b_rows_data = b.matrix_;
+  double *const *c_rows = c.matrix_;
+  ParallelFor(0, rows, ThreadCount(static_cast<long>(rows) * cols * inner),
+              [=](int from, int to) {
+                GemmRows(alpha, a_rows, transpose_a, b_rows_data, transpose_b,
+                         beta, c_rows, from, to, cols, inner);
+              });
+}
+
+void Axpy(double alpha, const S21Matrix &x, S21Matrix &y) {
+  y.CheckIfMatricesSizesAreEqual(x);
+  y.BeginWrite();
+  const double *source = x.data_.get();
+  double *target = y.data_.get();
+  const std::size_t size = static_cast<std::size_t>(y.rows_) * y.cols_;
+  for (std::size_t i = 0; i < size; i++) {
+    target[i] += alpha * source[i];
+  }
+}
+
+void Scal(double alpha, S21Matrix &x) {
+  x.BeginWrite();
+  double *target = x.data_.get();
+  const std::size_t size = static_cast<std::size_t>(x.rows_) * x.cols_;
+  for (std::size_t i = 0; i < size; i++) {
+    target[i] *= alpha;
+  }
+}
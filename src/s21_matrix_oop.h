@@ -2,55 +2,275 @@
 
 #include <cmath>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
 #include <utility>
+#include <vector>
+
+// Bounds checking of operator[] is fixed when the library is built and is
+// independent of NDEBUG. Clients must use the same value as the library,
+// e.g. -DS21_MATRIX_CHECKED=0 as make BUILD=release passes.
+#ifndef S21_MATRIX_CHECKED
+#define S21_MATRIX_CHECKED 1
+#endif
+
+enum class S21Op { kNoTranspose, kTranspose };
 
 class S21Matrix {
  public:
+  struct CacheStats {
+    unsigned long hits = 0;
+    unsigned long misses = 0;
+  };
+
+  // A row of the matrix as a contiguous range. Indexing is bounds checked
+  // only when S21_MATRIX_CHECKED is on, which is the default.
+  template <typename T>
+  class RowSpan {
+   public:
+    RowSpan(T* data, int size) noexcept : data_(data), size_(size) {}
+
+    T& operator[](int col) const {
+#if S21_MATRIX_CHECKED
+      if (col < 0 || col >= size_) {
+        throw std::out_of_range("Matrix index(es) are out of bounds");
+      }
+#endif
+      return data_[col];
+    }
+    T* data() const noexcept { return data_; }
+    int size() const noexcept { return size_; }
+    T* begin() const noexcept { return data_; }
+    T* end() const noexcept { return data_ + size_; }
+
+   private:
+    T* data_;
+    int size_;
+  };
+
+  // An element of a non-const matrix. Reading it is not a write; assigning
+  // to it detaches a shared copy and invalidates the cache first. It stands
+  // in for double& in expressions, increments and stream extraction, but
+  // does not bind to double& and is swapped with an unqualified swap.
+  class ElementRef {
+   public:
+    ElementRef(const ElementRef& other) noexcept = default;
+
+    ElementRef& operator=(double value) {
+      Write() = value;
+      return *this;
+    }
+    ElementRef& operator=(const ElementRef& other) {
+      return *this = static_cast<double>(other);
+    }
+    ElementRef& operator+=(double value) {
+      Write() += value;
+      return *this;
+    }
+    ElementRef& operator-=(double value) {
+      Write() -= value;
+      return *this;
+    }
+    ElementRef& operator*=(double value) {
+      Write() *= value;
+      return *this;
+    }
+    ElementRef& operator/=(double value) {
+      Write() /= value;
+      return *this;
+    }
+    ElementRef& operator++() {
+      ++Write();
+      return *this;
+    }
+    ElementRef& operator--() {
+      --Write();
+      return *this;
+    }
+    double operator++(int) { return Write()++; }
+    double operator--(int) { return Write()--; }
+    operator double() const noexcept { return matrix_->matrix_[row_][col_]; }
+
+    friend std::istream& operator>>(std::istream& in, ElementRef element) {
+      double value;
+      if (in >> value) element = value;
+      return in;
+    }
+    friend void swap(ElementRef left, ElementRef right) {
+      const double value = left;
+      left = static_cast<double>(right);
+      right = value;
+    }
+
+   private:
+    friend class S21Matrix;
+    ElementRef(S21Matrix* matrix, int row, int col) noexcept
+        : matrix_(matrix), row_(row), col_(col) {}
+
+    double& Write() {
+      matrix_->BeginWrite();
+      return matrix_->matrix_[row_][col_];
+    }
+
+    S21Matrix* matrix_;
+    int row_, col_;
+  };
+
   S21Matrix() noexcept;
   S21Matrix(int rows, int cols);
   S21Matrix(const S21Matrix& other);
   S21Matrix(S21Matrix&& other) noexcept;
   ~S21Matrix();
 
+  // Reads a matrix from a text file with one row per line and fields
+  // separated by spaces, tabs, commas or semicolons. ToText writes the
+  // shortest representation that reads back to the same value.
+  static S21Matrix FromText(const std::string& path);
+  void ToText(const std::string& path, char separator = ' ') const;
+
   int GetRows() const noexcept;
   int GetCols() const noexcept;
   void SetRows(int rows);
   void SetCols(int cols);
+  // In copy-on-write mode copies share storage and a copy detaches the first
+  // time it is written to. Spans and iterators taken before a copy was made
+  // still point into the shared storage.
+  bool IsCopyOnWrite() const noexcept;
+  void SetCopyOnWrite(bool enabled);
 
   bool EqMatrix(const S21Matrix& other) const noexcept;
   void SumMatrix(const S21Matrix& other);
   void SubMatrix(const S21Matrix& other);
-  void MulNumber(const double num) noexcept;
+  void MulNumber(const double num);
   void MulMatrix(const S21Matrix& other);
   S21Matrix CalcComplements() const;
   S21Matrix Transpose() const;
+  void TransposeInPlace();
   double Determinant() const;
   S21Matrix InverseMatrix() const;
+  // Determinant and InverseMatrix results are cached until the next write.
+  // The LU factors of a Determinant call are kept until InverseMatrix has
+  // used them; ClearCache releases everything early. Writes through
+  // operator() and At are always seen, but spans and iterators only
+  // invalidate the cache when they are taken, so do not hold them across one
+  // of these calls. The cache has its own lock, so const calls and copies may
+  // run concurrently on one matrix like any other reads.
+  CacheStats GetCacheStats() const;
+  void ResetCacheStats();
+  void ClearCache() const;
+  S21Matrix Pow(unsigned int power) const;
+  S21Matrix Exp() const;
 
   S21Matrix operator+(const S21Matrix& other);
   S21Matrix operator-(const S21Matrix& other);
   S21Matrix operator*(const S21Matrix& other);
   S21Matrix operator*(const double mul);
   bool operator==(const S21Matrix& other) const noexcept;
+  S21Matrix& operator=(const S21Matrix& other);
   S21Matrix& operator=(S21Matrix&& other);
   S21Matrix operator+=(const S21Matrix& other);
   S21Matrix operator-=(const S21Matrix& other);
   S21Matrix operator*=(const S21Matrix& other);
   S21Matrix operator*=(const double mul);
-  double& operator()(int row, int col) const;
+  ElementRef operator()(int row, int col);
+  const double& operator()(int row, int col) const;
+
+  // At, Row and CRow are always bounds checked, operator[] follows
+  // S21_MATRIX_CHECKED. Elements are stored row after row, so begin() and
+  // end() span the whole matrix for standard algorithms. Non-const spans
+  // and iterators are for writing and count as a write as soon as they are
+  // taken: they detach a shared copy and invalidate the cache. To read a
+  // non-const matrix use CRow, cbegin and cend, which do neither.
+  ElementRef At(int row, int col);
+  const double& At(int row, int col) const;
+  RowSpan<double> operator[](int row);
+  RowSpan<const double> operator[](int row) const;
+  RowSpan<double> Row(int row);
+  RowSpan<const double> Row(int row) const;
+  RowSpan<const double> CRow(int row) const;
+  double* begin();
+  double* end();
+  const double* begin() const noexcept;
+  const double* end() const noexcept;
+  const double* cbegin() const noexcept;
+  const double* cend() const noexcept;
 
  private:
+  friend class S21InverseTracker;
+  friend void Gemm(double alpha, const S21Matrix& a, S21Op op_a,
+                   const S21Matrix& b, S21Op op_b, double beta, S21Matrix& c);
+  friend void Axpy(double alpha, const S21Matrix& x, S21Matrix& y);
+  friend void Scal(double alpha, S21Matrix& x);
+
+  struct Factorization;
+  struct Cache {
+    unsigned long version = 0;
+    bool has_determinant = false;
+    double determinant = 0;
+    std::shared_ptr<const Factorization> factorization;
+    std::shared_ptr<const S21Matrix> inverse;
+  };
+
   int rows_, cols_;
   double** matrix_;
+  std::shared_ptr<double[]> data_;
+  bool copy_on_write_ = false;
+  unsigned long version_ = 0;
+  mutable std::mutex cache_mutex_;
+  mutable Cache cache_;
+  mutable CacheStats cache_stats_;
 
   void ConstructMatrix();
+  void LinkRows() noexcept;
   void CopyMatrix(const S21Matrix& other);
+  void ShareMatrix(const S21Matrix& other);
+  void Detach();
+  void BeginWrite();
+  Cache CopyCache() const;
+  void SyncCache() const noexcept;
+  std::shared_ptr<const S21Matrix> StoreCache(
+      double determinant, std::shared_ptr<const Factorization> factorization,
+      std::shared_ptr<const S21Matrix> inverse) const;
   void DestructMatrix() noexcept;
   void FillMatrix(S21Matrix& new_matrix, int rows, int cols);
+  void FillIdentity() noexcept;
+  void Swap(S21Matrix& other) noexcept;
+  static void MultiplyInto(const S21Matrix& left, const S21Matrix& right,
+                           S21Matrix& result);
+  int LuDecompose(std::vector<int>& pivots);
+  void LuSolve(const std::vector<int>& pivots, S21Matrix& rhs) const;
   void CheckIfMatricesSizesAreEqual(const S21Matrix& other) const;
   void CheckIfMatrixIsSquare() const;
   void ComplementsHandle(S21Matrix& complements) const;
   void FindMinor(S21Matrix& minor, int row, int col) const noexcept;
   double DeterminantHandle() const;
   void CheckIfIndexIsOutOfBounds(int row, int col) const;
-};
\ No newline at end of file
+};
+
+// Defined here so that both indices of m[row][col] are checked under the
+// same S21_MATRIX_CHECKED.
+inline S21Matrix::RowSpan<double> S21Matrix::operator[](int row) {
+#if S21_MATRIX_CHECKED
+  CheckIfIndexIsOutOfBounds(row, 0);
+#endif
+  BeginWrite();
+  return RowSpan<double>(matrix_[row], cols_);
+}
+
+inline S21Matrix::RowSpan<const double> S21Matrix::operator[](
+    int row) const {
+#if S21_MATRIX_CHECKED
+  CheckIfIndexIsOutOfBounds(row, 0);
+#endif
+  return RowSpan<const double>(matrix_[row], cols_);
+}
+
+// BLAS-style kernels that write into an existing matrix without allocating:
+// C = alpha * op(A) * op(B) + beta * C, Y = alpha * X + Y and X = alpha * X.
+// Sizes are checked once up front; C may not be A or B.
+void Gemm(double alpha, const S21Matrix& a, S21Op op_a, const S21Matrix& b,
+          S21Op op_b, double beta, S21Matrix& c);
+void Axpy(double alpha, const S21Matrix& x, S21Matrix& y);
+void Scal(double alpha, S21Matrix& x);
@@ -0,0 +1,115 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <thread>
+
+#include "s21_matrix_oop.h"
+#include "s21_thread_pool.h"
+
+namespace {
+
+template <typename Function>
+double Seconds(Function function) {
+  const auto start = std::chrono::steady_clock::now();
+  function();
+  const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return elapsed.count();
+}
+
+void BenchText(int rows, int cols) {
+  const char *path = "s21_bench_matrix.txt";
+  S21Matrix matrix(rows, cols);
+  std::mt19937_64 engine(21);
+  std::uniform_real_distribution<double> distribution(-1e6, 1e6);
+  for (int i = 0; i < rows; i++) {
+    for (int j = 0; j < cols; j++) {
+      matrix(i, j) = distribution(engine);
+    }
+  }
+  const double write = Seconds([&] { matrix.ToText(path); });
+  S21Matrix parsed;
+  const double read = Seconds([&] { parsed = S21Matrix::FromText(path); });
+  S21Matrix streamed(rows, cols);
+  const double stream = Seconds([&] {
+    std::ifstream file(path);
+    for (int i = 0; i < rows; i++) {
+      for (int j = 0; j < cols; j++) {
+        file >> streamed(i, j);
+      }
+    }
+  });
+  std::ifstream size_probe(path, std::ios::binary | std::ios::ate);
+  const double megabytes = static_cast<double>(size_probe.tellg()) / 1e6;
+  std::remove(path);
+  std::printf("text %dx%d (%.1f MB): ToText %.3fs, FromText %.3fs, "
+              "iostream %.3fs, equal %d\n",
+              rows, cols, megabytes, write, read, stream,
+              parsed == streamed);
+}
+
+void BenchLu(int size) {
+  S21Matrix matrix(size, size);
+  std::mt19937_64 engine(21);
+  std::uniform_real_distribution<double> distribution(-1, 1);
+  for (int i = 0; i < size; i++) {
+    for (int j = 0; j < size; j++) {
+      matrix(i, j) = distribution(engine);
+    }
+  }
+  const int hardware =
+      std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+  for (int threads = 1;; threads *= 2) {
+    if (threads > hardware) threads = hardware;
+    S21ThreadPool::Shared().SetThreads(threads);
+    // Every run starts from a fresh matrix so no cached result is reused.
+    S21Matrix determinant_input(matrix), inverse_input(matrix);
+    determinant_input.MulNumber(1);
+    inverse_input.MulNumber(1);
+    const double determinant =
+        Seconds([&] { determinant_input.Determinant(); });
+    const double inverse = Seconds([&] { inverse_input.InverseMatrix(); });
+    std::printf("lu %dx%d, %d threads: Determinant %.3fs, "
+                "InverseMatrix %.3fs\n",
+                size, size, threads, determinant, inverse);
+    if (threads >= hardware) break;
+  }
+}
+
+// Sums the rows of a copy-on-write matrix that shares its storage. CRow
+// reads in place, while Row is a write and first copies the whole matrix.
+void BenchRows(int rows, int cols) {
+  S21Matrix matrix(rows, cols);
+  matrix.SetCopyOnWrite(true);
+  double read_sum = 0, write_sum = 0;
+  S21Matrix reader(matrix), writer(matrix);
+  const double read = Seconds([&] {
+    for (int i = 0; i < rows; i++) {
+      for (double value : reader.CRow(i)) read_sum += value;
+    }
+  });
+  const double write = Seconds([&] {
+    for (int i = 0; i < rows; i++) {
+      for (double value : writer.Row(i)) write_sum += value;
+    }
+  });
+  std::printf("rows %dx%d, shared: CRow %.3fs, Row %.3fs, equal %d\n", rows,
+              cols, read, write, read_sum == write_sum);
+}
+
+}  // namespace
+
+// Usage: make bench ARGS="rows cols lu_size". A 7000x7000 text matrix
+// produces a file of about 1 GB.
+int main(int argc, char *argv[]) {
+  const int rows = argc > 2 ? std::atoi(argv[1]) : 2000;
+  const int cols = argc > 2 ? std::atoi(argv[2]) : 2000;
+  const int lu_size = argc > 3 ? std::atoi(argv[3]) : 1024;
+  BenchText(rows, cols);
+  BenchRows(rows, cols);
+  BenchLu(lu_size);
+  return 0;
+}
@@ -2,6 +2,18 @@
 
 #include <gtest/gtest.h>
 
+#include "s21_inverse_tracker.h"
+#include "s21_matrix_backend.h"
+#include "s21_thread_pool.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <fstream>
+#include <numeric>
+#include <sstream>
+#include <thread>
+
 void FillMatrix(S21Matrix &matrix, double *array, int rows, int cols) {
   for (int i = 0; i < rows; i++) {
     for (int j = 0; j < cols; j++) {
@@ -40,6 +52,82 @@ TEST(CreateMatrix, Move) {
   EXPECT_EQ(mtrx_move.GetCols(), 3);
 }
 
+TEST(CopyOnWrite, DeepCopyByDefault) {
+  S21Matrix matrix;
+  S21Matrix matrix_copy(matrix);
+  const S21Matrix &view = matrix, &view_copy = matrix_copy;
+  EXPECT_EQ(matrix.IsCopyOnWrite(), false);
+  EXPECT_NE(&view(0, 0), &view_copy(0, 0));
+}
+
+TEST(CopyOnWrite, SharesUntilWrite) {
+  S21Matrix matrix;
+  double array[9] = {1, 2, 3, 4, 5, 6, 7, 8, 9};
+  FillMatrix(matrix, array, 3, 3);
+  matrix.SetCopyOnWrite(true);
+  S21Matrix matrix_copy(matrix);
+  const S21Matrix &view = matrix, &view_copy = matrix_copy;
+  EXPECT_EQ(matrix_copy.IsCopyOnWrite(), true);
+  EXPECT_EQ(&view(0, 0), &view_copy(0, 0));
+  matrix_copy(1, 1) = 50;
+  EXPECT_NE(&view(0, 0), &view_copy(0, 0));
+  EXPECT_EQ(matrix(1, 1), 5);
+  EXPECT_EQ(matrix_copy(1, 1), 50);
+}
+
+TEST(CopyOnWrite, ReadsDoNotDetach) {
+  S21Matrix matrix;
+  double array[9] = {1, 2, 3, 4, 5, 6, 7, 8, 9};
+  FillMatrix(matrix, array, 3, 3);
+  matrix.SetCopyOnWrite(true);
+  S21Matrix matrix_copy(matrix);
+  const S21Matrix &view = matrix, &view_copy = matrix_copy;
+  double sum = matrix_copy(1, 1) + matrix_copy.At(2, 2);
+  EXPECT_EQ(sum, 14);
+  EXPECT_EQ(&view(0, 0), &view_copy(0, 0));
+  matrix_copy(0, 0) += 1;
+  EXPECT_NE(&view(0, 0), &view_copy(0, 0));
+  EXPECT_EQ(matrix(0, 0), 1);
+  EXPECT_EQ(matrix_copy(0, 0), 2);
+}
+
+TEST(CopyOnWrite, ElementOperators) {
+  S21Matrix matrix;
+  double array[9] = {1, 2, 3, 4, 5, 6, 7, 8, 9};
+  FillMatrix(matrix, array, 3, 3);
+  matrix.SetCopyOnWrite(true);
+  S21Matrix matrix_copy(matrix);
+  EXPECT_EQ(matrix_copy(0, 0)++, 1);
+  EXPECT_EQ(++matrix_copy(0, 1), 3);
+  EXPECT_EQ(matrix_copy(0, 2)--, 3);
+  EXPECT_EQ(--matrix_copy(1, 0), 3);
+  swap(matrix_copy(1, 1), matrix_copy(2, 2));
+  std::istringstream in("42 x");
+  in >> matrix_copy(2, 0);
+  in >> matrix_copy(2, 1);
+  EXPECT_EQ(in.fail(), true);
+  double array_check[9] = {2, 3, 2, 3, 9, 6, 42, 8, 5};
+  S21Matrix matrix_check;
+  FillMatrix(matrix_check, array_check, 3, 3);
+  EXPECT_EQ(matrix_copy.EqMatrix(matrix_check), true);
+  EXPECT_EQ(matrix(0, 0), 1);
+  EXPECT_EQ(matrix(2, 0), 7);
+}
+
+TEST(CopyOnWrite, MutatingMethodsDetach) {
+  S21Matrix matrix;
+  double array[9] = {1, 2, 3, 4, 5, 6, 7, 8, 9};
+  FillMatrix(matrix, array, 3, 3);
+  matrix.SetCopyOnWrite(true);
+  S21Matrix matrix_copy = matrix;
+  S21Matrix matrix_check;
+  FillMatrix(matrix_check, array, 3, 3);
+  matrix_copy.MulNumber(2);
+  matrix_copy.TransposeInPlace();
+  matrix_copy = matrix.Pow(3);
+  EXPECT_EQ(matrix.EqMatrix(matrix_check), true);
+}
+
 TEST(EqualMatrix, Eq) {
   S21Matrix matrix;
   S21Matrix other;
@@ -282,6 +370,77 @@ TEST(ReloadBrackes, OutOfRangeExceptionSmaller) {
   EXPECT_THROW(matrix(1, -1), std::out_of_range);
 }
 
+TEST(Access, At) {
+  S21Matrix matrix;
+  const S21Matrix &view = matrix;
+  matrix.At(2, 1) = 4;
+  EXPECT_EQ(view.At(2, 1), 4);
+  EXPECT_THROW(matrix.At(3, 0), std::out_of_range);
+  EXPECT_THROW(view.At(0, -1), std::out_of_range);
+}
+
+TEST(Access, Rows) {
+  S21Matrix matrix(2, 3);
+  double array[6] = {3, 1, 2, 6, 5, 4};
+  FillMatrix(matrix, array, 2, 3);
+  std::sort(matrix.Row(1).begin(), matrix.Row(1).end());
+  EXPECT_EQ(matrix[1][0], 4);
+  EXPECT_EQ(matrix[1][2], 6);
+  matrix[0][1] = 10;
+  const S21Matrix &view = matrix;
+  EXPECT_EQ(view[0][1], 10);
+  EXPECT_EQ(view.Row(0).size(), 3);
+  EXPECT_THROW(matrix.Row(2), std::out_of_range);
+#if S21_MATRIX_CHECKED
+  EXPECT_THROW(matrix[0][3], std::out_of_range);
+  EXPECT_THROW(view[-1], std::out_of_range);
+#endif
+}
+
+TEST(Access, Iterators) {
+  S21Matrix matrix(2, 3);
+  std::iota(matrix.begin(), matrix.end(), 1.0);
+  const S21Matrix &view = matrix;
+  EXPECT_EQ(std::accumulate(view.begin(), view.end(), 0.0), 21);
+  EXPECT_EQ(matrix(1, 0), 4);
+  EXPECT_EQ(view.cend() - view.cbegin(), 6);
+}
+
+TEST(Access, WritesDetachAndInvalidate) {
+  S21Matrix matrix(2, 2);
+  double array[4] = {1, 2, 3, 4};
+  FillMatrix(matrix, array, 2, 2);
+  matrix.SetCopyOnWrite(true);
+  S21Matrix matrix_copy(matrix);
+  EXPECT_EQ(matrix.Determinant(), -2);
+  std::fill(matrix.begin(), matrix.end(), 1.0);
+  EXPECT_EQ(matrix.Determinant(), 0);
+  matrix[0][0] = 2;
+  EXPECT_EQ(matrix.Determinant(), 1);
+  EXPECT_EQ(matrix_copy(1, 1), 4);
+}
+
+TEST(Access, ConstReads) {
+  S21Matrix matrix(2, 2);
+  double array[4] = {1, 2, 3, 4};
+  FillMatrix(matrix, array, 2, 2);
+  matrix.SetCopyOnWrite(true);
+  S21Matrix matrix_copy(matrix);
+  EXPECT_EQ(matrix.Determinant(), -2);
+  double sum = std::accumulate(matrix.cbegin(), matrix.cend(), 0.0);
+  for (int i = 0; i < 2; i++) {
+    for (double value : matrix.CRow(i)) {
+      sum += value;
+    }
+  }
+  EXPECT_EQ(sum, 20);
+  EXPECT_EQ(matrix.CRow(1)[0], 3);
+  EXPECT_THROW(matrix.CRow(2), std::out_of_range);
+  EXPECT_EQ(matrix.cbegin(), matrix_copy.cbegin());
+  EXPECT_EQ(matrix.Determinant(), -2);
+  EXPECT_EQ(matrix.GetCacheStats().hits, 1u);
+}
+
 TEST(Transpose, Squard) {
   S21Matrix matrix;
   S21Matrix matrix_check(3, 3);
@@ -317,6 +476,51 @@ TEST(Transpose, ManyCols) {
   EXPECT_EQ(matrix_new.EqMatrix(matrix_check), true);
 }
 
+TEST(Transpose, Large) {
+  S21Matrix matrix(613, 517);
+  for (int i = 0; i < 613; i++) {
+    for (int j = 0; j < 517; j++) {
+      matrix(i, j) = i * 517 + j;
+    }
+  }
+  S21Matrix matrix_new(matrix.Transpose());
+  EXPECT_EQ(matrix_new.GetRows(), 517);
+  EXPECT_EQ(matrix_new.GetCols(), 613);
+  for (int i = 0; i < 517; i++) {
+    for (int j = 0; j < 613; j++) {
+      ASSERT_EQ(matrix_new(i, j), j * 517 + i);
+    }
+  }
+}
+
+TEST(TransposeInPlace, Basic) {
+  S21Matrix matrix;
+  S21Matrix matrix_check(3, 3);
+  double array[9] = {9, 8, 7, 6, 5, 4, 3, 2, 1};
+  double array_check[9] = {9, 6, 3, 8, 5, 2, 7, 4, 1};
+  FillMatrix(matrix, array, 3, 3);
+  FillMatrix(matrix_check, array_check, 3, 3);
+  matrix.TransposeInPlace();
+  EXPECT_EQ(matrix.EqMatrix(matrix_check), true);
+}
+
+TEST(TransposeInPlace, Large) {
+  S21Matrix matrix(151, 151);
+  for (int i = 0; i < 151; i++) {
+    for (int j = 0; j < 151; j++) {
+      matrix(i, j) = i * 151 + j;
+    }
+  }
+  S21Matrix matrix_check(matrix.Transpose());
+  matrix.TransposeInPlace();
+  EXPECT_EQ(matrix.EqMatrix(matrix_check), true);
+}
+
+TEST(TransposeInPlace, LogicError) {
+  S21Matrix matrix(3, 2);
+  EXPECT_THROW(matrix.TransposeInPlace(), std::logic_error);
+}
+
 TEST(CalcComplements, Basic) {
   S21Matrix matrix;
   S21Matrix matrix_check(3, 3);
@@ -399,6 +603,543 @@ TEST(Determinant, LogicError) {
   EXPECT_THROW(matrix.Determinant(), std::logic_error);
 }
 
+TEST(Determinant, Large) {
+  S21Matrix matrix(5, 5);
+  double array[25] = {2, 0, 0, 0, 1, 0, 3, 0, 1, 0, 0, 0, 4, 0, 0,
+                      0, 1, 0, 5, 0, 1, 0, 0, 0, 6};
+  FillMatrix(matrix, array, 5, 5);
+  EXPECT_NEAR(matrix.Determinant(), 11 * 14 * 4, 1e-9);
+}
+
+TEST(Inverse, Large) {
+  S21Matrix matrix(6, 6);
+  for (int i = 0; i < 6; i++) {
+    for (int j = 0; j < 6; j++) {
+      matrix(i, j) = (i == j) ? 10 : (i + 2 * j) % 5 - 2;
+    }
+  }
+  S21Matrix identity = matrix.Pow(0);
+  EXPECT_EQ((matrix * matrix.InverseMatrix()).EqMatrix(identity), true);
+}
+
+TEST(Cache, Hits) {
+  S21Matrix matrix;
+  double array[9] = {2, 5, 7, 6, 3, 4, 5, -2, -3};
+  FillMatrix(matrix, array, 3, 3);
+  S21Matrix inversed = matrix.InverseMatrix();
+  EXPECT_EQ(matrix.Determinant(), -1);
+  EXPECT_EQ(matrix.Determinant(), -1);
+  EXPECT_EQ(matrix.InverseMatrix().EqMatrix(inversed), true);
+  EXPECT_EQ(matrix.GetCacheStats().hits, 3u);
+  EXPECT_EQ(matrix.GetCacheStats().misses, 1u);
+  matrix.ResetCacheStats();
+  EXPECT_EQ(matrix.GetCacheStats().misses, 0u);
+}
+
+TEST(Cache, WritesInvalidate) {
+  S21Matrix matrix;
+  double array[9] = {2, 5, 7, 6, 3, 4, 5, -2, -3};
+  FillMatrix(matrix, array, 3, 3);
+  EXPECT_EQ(matrix.Determinant(), -1);
+  matrix(0, 0) = 3;
+  EXPECT_EQ(matrix.Determinant(), -2);
+  matrix.MulNumber(2);
+  EXPECT_EQ(matrix.Determinant(), -16);
+  matrix.SetRows(2);
+  EXPECT_THROW(matrix.Determinant(), std::logic_error);
+  matrix.SetCols(2);
+  EXPECT_EQ(matrix.Determinant(), 6 * 6 - 10 * 12);
+  EXPECT_EQ(matrix.GetCacheStats().hits, 0u);
+}
+
+TEST(Cache, ReadsKeepCache) {
+  S21Matrix matrix;
+  double array[9] = {2, 5, 7, 6, 3, 4, 5, -2, -3};
+  FillMatrix(matrix, array, 3, 3);
+  S21Matrix::ElementRef element = matrix(0, 0);
+  EXPECT_EQ(matrix.Determinant(), -1);
+  EXPECT_EQ(matrix(0, 0) + matrix.At(1, 1), 5);
+  EXPECT_EQ(matrix.Determinant(), -1);
+  EXPECT_EQ(matrix.GetCacheStats().hits, 1u);
+  EXPECT_EQ(matrix.GetCacheStats().misses, 1u);
+  element = 3;
+  EXPECT_EQ(matrix.Determinant(), -2);
+  EXPECT_EQ(matrix.GetCacheStats().misses, 2u);
+}
+
+TEST(Cache, Clear) {
+  S21Matrix matrix(4, 4);
+  double array[16] = {4, 1, 0, 2, 1, 5, 1, 0, 0, 1, 6, 1, 2, 0, 1, 7};
+  FillMatrix(matrix, array, 4, 4);
+  S21Matrix inversed = matrix.InverseMatrix();
+  const double determinant = matrix.Determinant();
+  matrix.ClearCache();
+  EXPECT_EQ(matrix.Determinant(), determinant);
+  EXPECT_EQ(matrix.InverseMatrix().EqMatrix(inversed), true);
+  EXPECT_EQ(matrix.GetCacheStats().hits, 1u);
+  EXPECT_EQ(matrix.GetCacheStats().misses, 3u);
+}
+
+TEST(Cache, ConcurrentReads) {
+  S21Matrix matrix(5, 5);
+  for (int i = 0; i < 5; i++) {
+    for (int j = 0; j < 5; j++) {
+      matrix(i, j) = (i == j ? 10 : 0) + i - j;
+    }
+  }
+  const S21Matrix check = matrix;
+  const double determinant = check.Determinant();
+  const S21Matrix inversed = check.InverseMatrix();
+  matrix.ClearCache();
+  std::vector<std::thread> threads;
+  std::atomic<int> failures{0};
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([&matrix, &failures, &inversed, determinant, t] {
+      const S21Matrix &view = matrix;
+      for (int run = 0; run < 50; run++) {
+        if ((run + t) % 3 == 0) view.ClearCache();
+        S21Matrix copy(view);
+        if (view.Determinant() != determinant ||
+            !view.InverseMatrix().EqMatrix(inversed) ||
+            !copy.InverseMatrix().EqMatrix(inversed)) {
+          failures++;
+        }
+      }
+    });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(failures, 0);
+}
+
+TEST(Gemm, Basic) {
+  S21Matrix a(2, 3), b(3, 2), c(2, 2), matrix_check(2, 2);
+  double array_a[6] = {1, 2, 3, 4, 5, 6};
+  double array_b[6] = {7, 8, 9, 10, 11, 12};
+  double array_c[4] = {1, 1, 1, 1};
+  double array_check[4] = {115, 127, 277, 307};
+  FillMatrix(a, array_a, 2, 3);
+  FillMatrix(b, array_b, 3, 2);
+  FillMatrix(c, array_c, 2, 2);
+  FillMatrix(matrix_check, array_check, 2, 2);
+  Gemm(2, a, S21Op::kNoTranspose, b, S21Op::kNoTranspose, -1, c);
+  EXPECT_EQ(c.EqMatrix(matrix_check), true);
+}
+
+TEST(Gemm, Transposed) {
+  S21Matrix a(3, 2), b(2, 3), c(2, 2);
+  double array_a[6] = {1, -2, 3, 0.5, 4, 6};
+  double array_b[6] = {7, 8, -9, 1, 2, 3};
+  FillMatrix(a, array_a, 3, 2);
+  FillMatrix(b, array_b, 2, 3);
+  S21Matrix a_t = a.Transpose(), b_t = b.Transpose();
+  Gemm(1, a, S21Op::kTranspose, b_t, S21Op::kNoTranspose, 0, c);
+  EXPECT_EQ(c.EqMatrix(a_t * b_t), true);
+  Gemm(1, a_t, S21Op::kNoTranspose, b, S21Op::kTranspose, 0, c);
+  EXPECT_EQ(c.EqMatrix(a_t * b_t), true);
+  Gemm(1, a, S21Op::kTranspose, b, S21Op::kTranspose, 0, c);
+  EXPECT_EQ(c.EqMatrix(a_t * b_t), true);
+}
+
+TEST(Gemm, InvalidArgument) {
+  S21Matrix a(2, 3), b(3, 2), c(2, 2), square(2, 2);
+  EXPECT_THROW(Gemm(1, a, S21Op::kNoTranspose, a, S21Op::kNoTranspose, 0, c),
+               std::invalid_argument);
+  EXPECT_THROW(Gemm(1, a, S21Op::kNoTranspose, b, S21Op::kNoTranspose, 0, a),
+               std::invalid_argument);
+  EXPECT_THROW(Gemm(1, square, S21Op::kNoTranspose, square,
+                    S21Op::kNoTranspose, 0, square),
+               std::invalid_argument);
+}
+
+TEST(Axpy, Basic) {
+  S21Matrix x(2, 2), y(2, 2), matrix_check(2, 2);
+  double array_x[4] = {1, 2, 3, 4};
+  double array_y[4] = {1, 1, 1, 1};
+  double array_check[4] = {-1.5, -4, -6.5, -9};
+  FillMatrix(x, array_x, 2, 2);
+  FillMatrix(y, array_y, 2, 2);
+  FillMatrix(matrix_check, array_check, 2, 2);
+  Axpy(2, x, y);
+  Scal(-0.5, y);
+  Axpy(-1, y, y);
+  Axpy(1, matrix_check, y);
+  EXPECT_EQ(y.EqMatrix(matrix_check), true);
+  EXPECT_THROW(Axpy(1, S21Matrix(2, 3), y), std::invalid_argument);
+}
+
+TEST(Pow, Zero) {
+  S21Matrix matrix;
+  S21Matrix matrix_check(3, 3);
+  double array[9] = {1, 8, 7, 6, 5, 4, 3, 2, 1};
+  double array_check[9] = {1, 0, 0, 0, 1, 0, 0, 0, 1};
+  FillMatrix(matrix, array, 3, 3);
+  FillMatrix(matrix_check, array_check, 3, 3);
+  EXPECT_EQ(matrix.Pow(0).EqMatrix(matrix_check), true);
+}
+
+TEST(Pow, Basic) {
+  S21Matrix matrix;
+  double array[9] = {1, 0.5, -1, 0.25, 1, 0, 2, -0.5, 1};
+  FillMatrix(matrix, array, 3, 3);
+  S21Matrix matrix_check(matrix);
+  for (int i = 1; i < 11; i++) {
+    matrix_check.MulMatrix(matrix);
+  }
+  EXPECT_EQ(matrix.Pow(11).EqMatrix(matrix_check), true);
+}
+
+TEST(Pow, LogicError) {
+  S21Matrix matrix(3, 2);
+  EXPECT_THROW(matrix.Pow(2), std::logic_error);
+}
+
+TEST(Pow, KeepsCopyOnWrite) {
+  S21Matrix matrix;
+  matrix.SetCopyOnWrite(true);
+  for (unsigned int power = 0; power < 4; power++) {
+    EXPECT_EQ(matrix.Pow(power).IsCopyOnWrite(), true);
+  }
+  EXPECT_EQ(matrix.Exp().IsCopyOnWrite(), true);
+  matrix.SetCopyOnWrite(false);
+  for (unsigned int power = 0; power < 4; power++) {
+    EXPECT_EQ(matrix.Pow(power).IsCopyOnWrite(), false);
+  }
+}
+
+TEST(Exp, Zero) {
+  S21Matrix matrix(2, 2);
+  S21Matrix matrix_check(2, 2);
+  double array_check[4] = {1, 0, 0, 1};
+  FillMatrix(matrix_check, array_check, 2, 2);
+  EXPECT_EQ(matrix.Exp().EqMatrix(matrix_check), true);
+}
+
+TEST(Exp, Nilpotent) {
+  S21Matrix matrix(2, 2);
+  S21Matrix matrix_check(2, 2);
+  double array[4] = {0, 3, 0, 0};
+  double array_check[4] = {1, 3, 0, 1};
+  FillMatrix(matrix, array, 2, 2);
+  FillMatrix(matrix_check, array_check, 2, 2);
+  EXPECT_EQ(matrix.Exp().EqMatrix(matrix_check), true);
+}
+
+TEST(Exp, Rotation) {
+  S21Matrix matrix(2, 2);
+  S21Matrix matrix_check(2, 2);
+  double array[4] = {0, -5, 5, 0};
+  double array_check[4] = {cos(5), -sin(5), sin(5), cos(5)};
+  FillMatrix(matrix, array, 2, 2);
+  FillMatrix(matrix_check, array_check, 2, 2);
+  EXPECT_EQ(matrix.Exp().EqMatrix(matrix_check), true);
+}
+
+TEST(Exp, LogicError) {
+  S21Matrix matrix(3, 2);
+  EXPECT_THROW(matrix.Exp(), std::logic_error);
+}
+
+TEST(Exp, NonFinite) {
+  S21Matrix matrix(2, 2);
+  matrix(0, 1) = INFINITY;
+  EXPECT_THROW(matrix.Exp(), std::logic_error);
+  matrix(0, 1) = NAN;
+  EXPECT_THROW(matrix.Exp(), std::logic_error);
+}
+
+void WriteFile(const char *path, const char *text) {
+  std::ofstream file(path, std::ios::binary);
+  file << text;
+}
+
+TEST(Text, RoundTrip) {
+  S21Matrix matrix(2, 3);
+  double array[6] = {0.1, 1.0 / 3, -1e-300, 12345678.9, 2.5e300, -0.0};
+  FillMatrix(matrix, array, 2, 3);
+  matrix.ToText("s21_text_test.txt", ',');
+  S21Matrix matrix_new = S21Matrix::FromText("s21_text_test.txt");
+  std::remove("s21_text_test.txt");
+  EXPECT_EQ(matrix_new.GetRows(), 2);
+  EXPECT_EQ(matrix_new.GetCols(), 3);
+  for (int i = 0; i < 2; i++) {
+    for (int j = 0; j < 3; j++) {
+      EXPECT_EQ(matrix_new(i, j), array[i * 3 + j]);
+    }
+  }
+}
+
+TEST(Text, Csv) {
+  S21Matrix matrix_check(3, 2);
+  double array_check[6] = {1, 2.5, -3, 4e2, 5, 6};
+  FillMatrix(matrix_check, array_check, 3, 2);
+  WriteFile("s21_text_test.txt", "+1, 2.5\r\n\r\n-3;\t4e2\r\n  5 +6");
+  S21Matrix matrix = S21Matrix::FromText("s21_text_test.txt");
+  std::remove("s21_text_test.txt");
+  EXPECT_EQ(matrix.EqMatrix(matrix_check), true);
+}
+
+TEST(Text, InvalidArgument) {
+  WriteFile("s21_text_test.txt", "1 2\n3\n");
+  EXPECT_THROW(S21Matrix::FromText("s21_text_test.txt"),
+               std::invalid_argument);
+  WriteFile("s21_text_test.txt", "1 2\n3 x\n");
+  EXPECT_THROW(S21Matrix::FromText("s21_text_test.txt"),
+               std::invalid_argument);
+  WriteFile("s21_text_test.txt", " \n");
+  EXPECT_THROW(S21Matrix::FromText("s21_text_test.txt"),
+               std::invalid_argument);
+  std::remove("s21_text_test.txt");
+}
+
+TEST(Text, EmptyFields) {
+  const char *texts[5] = {"1,,2\n3,4,5\n", "1,2\n3,,4\n", "1;2;\n3;4;\n",
+                          ",1,2\n", "+\n"};
+  for (const char *text : texts) {
+    WriteFile("s21_text_test.txt", text);
+    EXPECT_THROW(S21Matrix::FromText("s21_text_test.txt"),
+                 std::invalid_argument);
+  }
+  std::remove("s21_text_test.txt");
+}
+
+TEST(Text, WriteError) {
+  if (std::FILE *probe = std::fopen("/dev/full", "wb")) {
+    std::fclose(probe);
+    S21Matrix matrix;
+    EXPECT_THROW(matrix.ToText("/dev/full"), std::runtime_error);
+  }
+}
+
+TEST(Text, MissingFile) {
+  EXPECT_THROW(S21Matrix::FromText("s21_missing_file.txt"),
+               std::runtime_error);
+}
+
+TEST(InverseTracker, Basic) {
+  S21Matrix matrix;
+  double array[9] = {2, 5, 7, 6, 3, 4, 5, -2, -3};
+  FillMatrix(matrix, array, 3, 3);
+  S21InverseTracker tracker(matrix);
+  EXPECT_NEAR(tracker.GetDeterminant(), matrix.Determinant(), 1e-9);
+  EXPECT_EQ(tracker.GetInverse().EqMatrix(matrix.InverseMatrix()), true);
+}
+
+TEST(InverseTracker, UpdateRowAndCol) {
+  S21Matrix matrix(4, 4);
+  double array[16] = {4, 1, 0, 2, 1, 5, 1, 0, 0, 1, 6, 1, 2, 0, 1, 7};
+  FillMatrix(matrix, array, 4, 4);
+  S21InverseTracker tracker(matrix);
+  S21Matrix row(1, 4), col(4, 1);
+  double array_row[4] = {1, -2, 3, 8};
+  double array_col[4] = {0.5, 9, -1, 2};
+  FillMatrix(row, array_row, 1, 4);
+  FillMatrix(col, array_col, 4, 1);
+  tracker.UpdateRow(3, row);
+  tracker.UpdateCol(1, col);
+  for (int j = 0; j < 4; j++) {
+    matrix(3, j) = array_row[j];
+  }
+  for (int i = 0; i < 4; i++) {
+    matrix(i, 1) = array_col[i];
+  }
+  EXPECT_EQ(tracker.GetMatrix().EqMatrix(matrix), true);
+  EXPECT_NEAR(tracker.GetDeterminant(), matrix.Determinant(), 1e-9);
+  EXPECT_EQ(tracker.GetInverse().EqMatrix(matrix.InverseMatrix()), true);
+  EXPECT_EQ(tracker.GetRefactorCount(), 0);
+}
+
+TEST(InverseTracker, RankUpdate) {
+  S21Matrix matrix(3, 3), u(3, 2), v(3, 2);
+  double array[9] = {3, 1, 0, 1, 4, 1, 0, 1, 5};
+  double array_u[6] = {1, 0, 0, 2, 1, 1};
+  double array_v[6] = {0.5, 0, 1, 1, 0, -1};
+  FillMatrix(matrix, array, 3, 3);
+  FillMatrix(u, array_u, 3, 2);
+  FillMatrix(v, array_v, 3, 2);
+  S21InverseTracker tracker(matrix);
+  tracker.RankUpdate(u, v);
+  S21Matrix updated = matrix + u * v.Transpose();
+  EXPECT_NEAR(tracker.GetDeterminant(), updated.Determinant(), 1e-9);
+  EXPECT_EQ(tracker.GetInverse().EqMatrix(updated.InverseMatrix()), true);
+}
+
+TEST(InverseTracker, DriftRefactor) {
+  const int size = 6;
+  S21Matrix matrix(size, size), row(1, size);
+  for (int i = 0; i < size; i++) {
+    for (int j = 0; j < size; j++) {
+      matrix(i, j) = (i == j ? 7.0 : 0.0) + 1.0 / (i + 2 * j + 3);
+    }
+  }
+  S21InverseTracker tracker(matrix);
+  EXPECT_THROW(tracker.SetDriftThreshold(0), std::invalid_argument);
+  tracker.SetDriftThreshold(1e-300);
+  EXPECT_EQ(tracker.GetDriftThreshold(), 1e-300);
+  for (int update = 0; update < 4; update++) {
+    for (int j = 0; j < size; j++) {
+      row(0, j) = matrix(update, j) + sin(update + j * 0.7) / 3;
+      matrix(update, j) = row(0, j);
+    }
+    const int refactors = tracker.GetRefactorCount();
+    tracker.UpdateRow(update, row);
+    EXPECT_EQ(tracker.GetRefactorCount(), refactors + 1);
+    EXPECT_LT(tracker.GetDrift(), 1e-12);
+  }
+  EXPECT_EQ(tracker.GetMatrix().EqMatrix(matrix), true);
+  EXPECT_NEAR(tracker.GetDeterminant(), matrix.Determinant(), 1e-9);
+  EXPECT_EQ(tracker.GetInverse().EqMatrix(matrix.InverseMatrix()), true);
+}
+
+TEST(InverseTracker, IllConditioned) {
+  const int size = 9;
+  S21Matrix matrix(size, size), row(1, size);
+  for (int i = 0; i < size; i++) {
+    for (int j = 0; j < size; j++) {
+      matrix(i, j) = 1.0 / (i + j + 1);
+    }
+  }
+  S21InverseTracker tracker(matrix);
+  EXPECT_LT(tracker.GetDrift(), tracker.GetDriftThreshold());
+  for (int update = 0; update < 5; update++) {
+    for (int j = 0; j < size; j++) {
+      matrix(update, j) *= 1 + 1e-3 * (j + 1);
+      row(0, j) = matrix(update, j);
+    }
+    tracker.UpdateRow(update, row);
+    EXPECT_LT(tracker.GetDrift(), tracker.GetDriftThreshold());
+  }
+  EXPECT_EQ(tracker.GetRefactorCount(), 0);
+  const double determinant = matrix.Determinant();
+  EXPECT_NEAR(tracker.GetDeterminant(), determinant, 1e-6 * fabs(determinant));
+}
+
+TEST(InverseTracker, SingularUpdate) {
+  S21Matrix matrix(2, 2), row(1, 2);
+  double array[4] = {1, 2, 3, 4};
+  double array_row[2] = {1, 2};
+  FillMatrix(matrix, array, 2, 2);
+  FillMatrix(row, array_row, 1, 2);
+  S21InverseTracker tracker(matrix);
+  EXPECT_THROW(tracker.UpdateRow(1, row), std::logic_error);
+  EXPECT_EQ(tracker.GetMatrix().EqMatrix(matrix), true);
+  EXPECT_THROW(tracker.UpdateRow(2, row), std::out_of_range);
+  EXPECT_THROW(tracker.UpdateCol(0, row), std::invalid_argument);
+}
+
+TEST(TaskGraph, Dependencies) {
+  S21ThreadPool pool(4);
+  S21TaskGraph graph;
+  std::vector<int> order(64, -1);
+  std::atomic<int> clock{0};
+  std::vector<int> tasks;
+  for (int i = 0; i < 64; i++) {
+    std::vector<int> dependencies;
+    if (i >= 8) dependencies.push_back(tasks[i - 8]);
+    tasks.push_back(graph.Add([&order, &clock, i] { order[i] = clock++; },
+                              dependencies));
+  }
+  graph.Run(pool);
+  for (int i = 8; i < 64; i++) {
+    EXPECT_GT(order[i], order[i - 8]);
+  }
+}
+
+TEST(TaskGraph, Exception) {
+  S21ThreadPool pool(2);
+  S21TaskGraph graph;
+  int first = graph.Add([] { throw std::runtime_error("task failed"); });
+  bool ran = false;
+  graph.Add([&ran] { ran = true; }, {first});
+  EXPECT_THROW(graph.Run(pool), std::runtime_error);
+  EXPECT_EQ(ran, false);
+  EXPECT_THROW(graph.Add([] {}, {5}), std::out_of_range);
+
+  S21TaskGraph checked;
+  int counter = 0;
+  bool rejected_ran = false;
+  const int task = checked.Add([&counter] { counter++; });
+  EXPECT_THROW(checked.Add([&rejected_ran] { rejected_ran = true; },
+                           {task, 7}),
+               std::out_of_range);
+  checked.Run(pool);
+  EXPECT_EQ(counter, 1);
+  EXPECT_EQ(rejected_ran, false);
+}
+
+TEST(BlockedLu, DeterminantAndInverse) {
+  const int size = 300;
+  S21ThreadPool::Shared().SetThreads(4);
+  S21Matrix lower(size, size), upper(size, size);
+  double check = 1;
+  for (int i = 0; i < size; i++) {
+    for (int j = 0; j < size; j++) {
+      const double value = ((i * 7 + j * 13) % 11 - 5) / 50.0;
+      if (i > j) lower(i, j) = value;
+      if (i < j) upper(i, j) = value;
+    }
+    lower(i, i) = 1;
+    upper(i, i) = 1 + (i % 3 - 1) / 100.0;
+    check *= upper(i, i);
+  }
+  S21Matrix matrix = lower * upper;
+  EXPECT_NEAR(matrix.Determinant() / check, 1, 1e-9);
+  EXPECT_EQ((matrix * matrix.InverseMatrix()).EqMatrix(matrix.Pow(0)), true);
+  S21ThreadPool::Shared().SetThreads(
+      static_cast<int>(std::thread::hardware_concurrency()));
+}
+
+S21Matrix BackendInput(int rows, int cols) {
+  S21Matrix matrix(rows, cols);
+  for (int i = 0; i < rows; i++) {
+    for (int j = 0; j < cols; j++) {
+      matrix(i, j) = ((i * 31 + j * 17) % 23 - 11) / 7.0 + (i == j ? 9 : 0);
+    }
+  }
+  return matrix;
+}
+
+// Runs the same operations with every size sent to the BLAS backend and with
+// none of them, so builds with the backend compare it with the built-in path.
+TEST(Backend, MatchesBuiltIn) {
+  const S21BackendThresholds defaults = GetBackendThresholds();
+  S21Matrix results[2][5];
+  for (int run = 0; run < 2; run++) {
+    S21BackendThresholds thresholds;
+    thresholds.gemm = thresholds.lu = thresholds.transpose =
+        run ? INT_MAX : 1;
+    SetBackendThresholds(thresholds);
+    S21Matrix a = BackendInput(37, 29), b = BackendInput(29, 41);
+    S21Matrix square = BackendInput(45, 45);
+    results[run][0] = a * b;
+    results[run][1] = BackendInput(41, 37);
+    Gemm(0.5, b, S21Op::kTranspose, a, S21Op::kTranspose, 2,
+         results[run][1]);
+    results[run][2] = square.InverseMatrix();
+    results[run][3] = a.Transpose();
+    results[run][4] = S21Matrix(1, 1);
+    results[run][4](0, 0) = BackendInput(45, 45).Determinant();
+  }
+  SetBackendThresholds(defaults);
+  for (int i = 0; i < 4; i++) {
+    EXPECT_EQ(results[0][i].EqMatrix(results[1][i]), true) << i;
+  }
+  EXPECT_NEAR(results[0][4](0, 0) / results[1][4](0, 0), 1, 1e-12);
+}
+
+TEST(Backend, Singular) {
+  const S21BackendThresholds defaults = GetBackendThresholds();
+  SetBackendThresholds(S21BackendThresholds{1, 1, 1});
+  S21Matrix matrix = BackendInput(8, 8);
+  for (int j = 0; j < 8; j++) {
+    matrix(7, j) = matrix(0, j);
+  }
+  EXPECT_THROW(matrix.InverseMatrix(), std::logic_error);
+  EXPECT_EQ(matrix.Determinant(), 0);
+  SetBackendThresholds(defaults);
+}
+
 int main(int argc, char *argv[]) {
   testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
@@ -0,0 +1,178 @@
+#include "s21_thread_pool.h"
+
+#include <chrono>
+#include <stdexcept>
+
+namespace {
+
+thread_local const S21ThreadPool *current_pool = nullptr;
+thread_local int current_queue = 0;
+
+}  // namespace
+
+S21ThreadPool::S21ThreadPool(int threads) { Start(threads); }
+
+S21ThreadPool::~S21ThreadPool() { Stop(); }
+
+S21ThreadPool &S21ThreadPool::Shared() {
+  static S21ThreadPool pool(
+      static_cast<int>(std::thread::hardware_concurrency()));
+  return pool;
+}
+
+int S21ThreadPool::GetThreads() const noexcept {
+  return static_cast<int>(queues_.size());
+}
+
+void S21ThreadPool::SetThreads(int threads) {
+  Stop();
+  Start(threads);
+}
+
+void S21ThreadPool::Start(int threads) {
+  if (threads < 1) threads = 1;
+  stopping_ = false;
+  queues_.clear();
+  for (int i = 0; i < threads; i++) {
+    queues_.push_back(std::make_unique<Queue>());
+  }
+  for (int i = 1; i < threads; i++) {
+    workers_.emplace_back(&S21ThreadPool::WorkerLoop, this, i);
+  }
+}
+
+void S21ThreadPool::Stop() noexcept {
+  {
+    std::lock_guard<std::mutex> lock(sleep_mutex_);
+    stopping_ = true;
+  }
+  wake_.notify_all();
+  for (auto &worker : workers_) {
+    worker.join();
+  }
+  workers_.clear();
+}
+
+void S21ThreadPool::Submit(Task task) {
+  Queue &queue = *queues_[CurrentQueue()];
+  {
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    queue.tasks.push_back(std::move(task));
+  }
+  {
+    std::lock_guard<std::mutex> lock(sleep_mutex_);
+    queued_++;
+  }
+  wake_.notify_one();
+}
+
+bool S21ThreadPool::RunPending() {
+  Task task;
+  if (!Pop(CurrentQueue(), task)) return false;
+  task();
+  return true;
+}
+
+int S21ThreadPool::CurrentQueue() const noexcept {
+  return current_pool == this ? current_queue : 0;
+}
+
+bool S21ThreadPool::Pop(int index, Task &task) {
+  const int count = static_cast<int>(queues_.size());
+  for (int step = 0; step < count; step++) {
+    Queue &queue = *queues_[(index + step) % count];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) continue;
+    if (step == 0) {
+      task = std::move(queue.tasks.back());
+      queue.tasks.pop_back();
+    } else {
+      task = std::move(queue.tasks.front());
+      queue.tasks.pop_front();
+    }
+    queued_--;
+    return true;
+  }
+  return false;
+}
+
+void S21ThreadPool::WorkerLoop(int index) {
+  current_pool = this;
+  current_queue = index;
+  while (true) {
+    Task task;
+    if (Pop(index, task)) {
+      task();
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(sleep_mutex_);
+    wake_.wait(lock, [this] { return stopping_ || queued_ > 0; });
+    if (stopping_ && queued_ == 0) return;
+  }
+}
+
+int S21TaskGraph::Add(std::function<void()> task,
+                      const std::vector<int> &dependencies) {
+  const int index = static_cast<int>(nodes_.size());
+  for (int dependency : dependencies) {
+    if (dependency < 0 || dependency >= index) {
+      throw std::out_of_range("A task can only depend on earlier tasks");
+    }
+  }
+  nodes_.emplace_back();
+  nodes_.back().task = std::move(task);
+  for (int dependency : dependencies) {
+    nodes_[dependency].successors.push_back(index);
+    nodes_.back().dependencies++;
+  }
+  return index;
+}
+
+int S21TaskGraph::Add(std::function<void()> task) {
+  return Add(std::move(task), {});
+}
+
+void S21TaskGraph::Run(S21ThreadPool &pool) {
+  remaining_ = static_cast<int>(nodes_.size());
+  failed_ = false;
+  error_ = nullptr;
+  for (auto &node : nodes_) {
+    node.pending = node.dependencies;
+  }
+  for (int i = static_cast<int>(nodes_.size()) - 1; i >= 0; i--) {
+    if (!nodes_[i].dependencies) {
+      pool.Submit([this, &pool, i] { Execute(pool, i); });
+    }
+  }
+  while (remaining_ > 0) {
+    if (pool.RunPending()) continue;
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait_for(lock, std::chrono::microseconds(200),
+                   [this] { return remaining_ == 0; });
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (error_) std::rethrow_exception(error_);
+}
+
+void S21TaskGraph::Execute(S21ThreadPool &pool, int index) {
+  Node &node = nodes_[index];
+  if (!failed_) {
+    try {
+      node.task();
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (!failed_.exchange(true)) error_ = std::current_exception();
+    }
+  }
+  for (auto it = node.successors.rbegin(); it != node.successors.rend();
+       ++it) {
+    const int successor = *it;
+    if (--nodes_[successor].pending == 0) {
+      pool.Submit([this, &pool, successor] { Execute(pool, successor); });
+    }
+  }
+  // The count drops under the lock so Run cannot return, and the graph be
+  // destroyed, while this thread still touches it.
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (--remaining_ == 0) done_.notify_all();
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work-stealing pool: every worker owns a deque, pops its own tasks LIFO and
+// steals FIFO from the others when it runs dry. Threads that wait on a task
+// graph help by running queued tasks, so a pool of N threads runs N - 1
+// workers plus the waiting caller.
+class S21ThreadPool {
+ public:
+  using Task = std::function<void()>;
+
+  explicit S21ThreadPool(int threads);
+  S21ThreadPool(const S21ThreadPool& other) = delete;
+  S21ThreadPool& operator=(const S21ThreadPool& other) = delete;
+  ~S21ThreadPool();
+
+  // The pool used by the S21Matrix kernels, sized to the hardware.
+  static S21ThreadPool& Shared();
+
+  int GetThreads() const noexcept;
+  // Must not be called while tasks are queued or running.
+  void SetThreads(int threads);
+  void Submit(Task task);
+  bool RunPending();
+
+ private:
+  struct Queue {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  std::vector<std::unique_ptr<Queue>> queues_;
+  std::vector<std::thread> workers_;
+  std::mutex sleep_mutex_;
+  std::condition_variable wake_;
+  std::atomic<int> queued_{0};
+  bool stopping_ = false;
+
+  void Start(int threads);
+  void Stop() noexcept;
+  void WorkerLoop(int index);
+  int CurrentQueue() const noexcept;
+  bool Pop(int index, Task& task);
+};
+
+// Tasks with dependencies, run on a pool until all of them are done. When a
+// task finishes, its ready successors are pushed in reverse order, so the
+// finishing thread picks the earliest added one next. The first exception
+// thrown by a task cancels the tasks not started yet and is rethrown by Run.
+class S21TaskGraph {
+ public:
+  int Add(std::function<void()> task, const std::vector<int>& dependencies);
+  int Add(std::function<void()> task);
+  void Run(S21ThreadPool& pool);
+
+ private:
+  struct Node {
+    std::function<void()> task;
+    std::vector<int> successors;
+    int dependencies = 0;
+    std::atomic<int> pending{0};
+  };
+
+  std::deque<Node> nodes_;
+  std::atomic<int> remaining_{0};
+  std::atomic<bool> failed_{false};
+  std::exception_ptr error_;
+  std::mutex mutex_;
+  std::condition_variable done_;
+
+  void Execute(S21ThreadPool& pool, int index);
+};